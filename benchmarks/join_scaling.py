@@ -0,0 +1,68 @@
+# join_scaling.py
+# Author: pyHDT contributors - MIT License
+#
+# Measure how search_join scales with the number of threads, on a synthetic HDT file.
+# The synthetic dataset is a random graph with two predicates, and the benchmark
+# evaluates the chain join { ?x ex:p1 ?y . ?y ex:p2 ?z }.
+#
+# Usage:
+#   python benchmarks/join_scaling.py --triples 100000000 --threads 1 2 4 8 16 32 64
+#
+# Generating the HDT file requires the rdf2hdt tool from hdt-cpp to be in the PATH.
+import argparse
+import os
+import random
+import subprocess
+from time import time
+from hdt import HDTDocument
+
+PREDICATES = ["http://example.org/p1", "http://example.org/p2"]
+
+
+def generate(nt_path, hdt_path, nb_triples, nb_nodes, seed):
+    """Generate a random graph as N-Triples, then convert it to HDT"""
+    rng = random.Random(seed)
+    with open(nt_path, "w") as nt_file:
+        for i in range(nb_triples):
+            s = rng.randint(1, nb_nodes)
+            o = rng.randint(1, nb_nodes)
+            nt_file.write("<http://example.org/n%i> <%s> <http://example.org/n%i> .\n" % (s, PREDICATES[i % 2], o))
+    subprocess.check_call(["rdf2hdt", nt_path, hdt_path])
+    os.remove(nt_path)
+
+
+def run(document, threads, limit):
+    """Evaluate the join, and return (nb solutions, execution time in seconds)"""
+    start = time()
+    iterator = document.search_join([
+        ("?x", PREDICATES[0], "?y"),
+        ("?y", PREDICATES[1], "?z")
+    ], threads=threads)
+    nb_solutions = 0
+    for bindings in iterator:
+        nb_solutions += 1
+        if limit > 0 and nb_solutions >= limit:
+            break
+    return nb_solutions, time() - start
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Benchmark the scalability of search_join with the number of threads")
+    parser.add_argument("--hdt", default="synthetic.hdt", help="Path to the synthetic HDT file, generated if missing")
+    parser.add_argument("--triples", type=int, default=100000000, help="Number of triples of the synthetic dataset")
+    parser.add_argument("--nodes", type=int, default=10000000, help="Number of nodes of the synthetic dataset")
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, 8, 16, 32, 64])
+    parser.add_argument("--limit", type=int, default=0, help="Only read the first solutions (0 to read all of them)")
+    parser.add_argument("--seed", type=int, default=42)
+    args = parser.parse_args()
+
+    if not os.path.exists(args.hdt):
+        generate(args.hdt + ".nt", args.hdt, args.triples, args.nodes, args.seed)
+    document = HDTDocument(args.hdt)
+
+    print("threads\tsolutions\ttime (s)\tspeedup")
+    reference = None
+    for threads in args.threads:
+        nb_solutions, elapsed = run(document, threads, args.limit)
+        reference = reference if reference is not None else elapsed
+        print("%i\t%i\t%.3f\t%.2f" % (threads, nb_solutions, elapsed, reference / elapsed))
@@ -0,0 +1,70 @@
+/**
+ * array_utils.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_ARRAY_UTILS_HPP
+#define PYHDT_ARRAY_UTILS_HPP
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+
+/*!
+ * Convert a vector into a numpy array of shape (rows, cols), without copy:
+ * the vector is moved on the heap, and freed when the array is garbage collected.
+ * Must be called with the GIL held.
+ * @param  values Values of the array, in row-major order
+ * @param  cols   Number of columns, or 0 for a 1-dimensional array
+ * @return        Array viewing the values
+ */
+template <typename T>
+py::array_t<T> toArray(std::vector<T> &&values, size_t cols = 0) {
+  std::vector<T> *data = new std::vector<T>(std::move(values));
+  py::capsule owner(data, [](void *ptr) { delete reinterpret_cast<std::vector<T> *>(ptr); });
+  if (cols == 0) {
+    return py::array_t<T>({(py::ssize_t) data->size()}, {(py::ssize_t) sizeof(T)}, data->data(), owner);
+  }
+  return py::array_t<T>({(py::ssize_t) (data->size() / cols), (py::ssize_t) cols},
+                        {(py::ssize_t) (cols * sizeof(T)), (py::ssize_t) sizeof(T)},
+                        data->data(), owner);
+}
+
+/*!
+ * Convert a vector of 0/1 bytes into a numpy array of booleans, without copy
+ * @param  values Bytes, 1 for True and 0 for False
+ * @return        Array of booleans viewing the bytes
+ */
+inline py::array_t<bool> toBoolArray(std::vector<uint8_t> &&values) {
+  std::vector<uint8_t> *data = new std::vector<uint8_t>(std::move(values));
+  py::capsule owner(data, [](void *ptr) { delete reinterpret_cast<std::vector<uint8_t> *>(ptr); });
+  return py::array_t<bool>({(py::ssize_t) data->size()}, {(py::ssize_t) sizeof(bool)},
+                           reinterpret_cast<bool *>(data->data()), owner);
+}
+
+/*!
+ * Copy a 1-dimensional numpy array into a vector. Must be called with the GIL held.
+ * @param  array Numpy array
+ * @param  name  Name of the array, used in error messages
+ * @return       Copy of the values of the array
+ */
+template <typename T>
+std::vector<T> toVector(py::array_t<T> &array, const std::string &name) {
+  if (array.ndim() != 1) {
+    throw std::runtime_error(name + " must be a 1-dimensional array");
+  }
+  auto view = array.template unchecked<1>();
+  std::vector<T> values;
+  values.reserve(array.shape(0));
+  for (py::ssize_t i = 0; i < array.shape(0); i++) {
+    values.push_back(view(i));
+  }
+  return values;
+}
+
+#endif /* PYHDT_ARRAY_UTILS_HPP */
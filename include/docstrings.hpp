@@ -19,6 +19,10 @@ const char *MODULE_DOC = R"(
 const char *HDT_DOCUMENT_CLASS_DOC = R"(
   An HDTDocument enables to load and query a HDT file.
   Indexes are automatically generated if missing.
+
+  The HDT file is mapped in memory once per process: documents opened on the same file share its mapping.
+  Documents can be opened before forking worker processes, which then share the mapped pages, and are pickled
+  by path, with their hop configuration, join thresholds and type index, so unpickling a document reopens the file or reuses its mapping.
 )";
 
 const char *HDT_DOCUMENT_GETFILEPATH_DOC = R"(
@@ -47,15 +51,31 @@ const char *HDT_DOCUMENT_GETNBSHARED_DOC = R"(
 
 const char *HDT_DOCUMENT_SEARCH_TRIPLES_DOC = R"(
   Search for RDF triples matching the triple pattern { ``subject`` ``predicate`` ``object`` },
-  with an optional ``limit`` and ``offset``.
+  with an optional ``limit``, ``offset`` and ``filters``.
   Use empty strings (``""``) to indicate SPARQL variables.
 
+  Filters are ``tuple`` (target, operator) or (target, operator, argument), where the target
+  is ``"subject"``, ``"predicate"`` or ``"object"``. Available operators are:
+
+    - ``"iri"``: the term is an IRI.
+    - ``"literal"``: the term is a literal.
+    - ``"prefix"``: the term starts with the argument, e.g., a namespace.
+    - ``"lang"``: the term is a literal with the argument as language tag (any tag if omitted).
+
+  Filters are evaluated on the IDs of the HDT Dictionary while scanning the triples, so
+  filtered triples are never decoded. A ``"lang"`` filter decodes each literal once, when it is compiled.
+
   Args:
     - subject ``str``: The subject of the triple pattern to seach for.
     - predicate ``str``: The predicate of the triple pattern to seach for.
     - obj ``str``: The object of the triple pattern ot seach for.
     - limit ``int`` ``optional``: Maximum number of triples to search for.
     - offset ``int`` ``optional``: Number of matching triples to skip before returning results.
+    - filters ``list`` ``optional``: Filters that matching triples must pass.
+    - prefetch ``int`` ``optional``: If greater than 0, matching triples are read and decoded by a
+      background thread, up to ``prefetch`` triples ahead of the iteration.
+    - raw ``bool`` ``optional``: If True, RDF terms are returned as ``bytes``, without UTF-8 decoding.
+      In this mode, :meth:`hdt.TripleIterator.next_batch` returns a single ``bytes`` buffer per batch.
 
   Return:
     A 2-elements ``tuple`` (:class:`hdt.TripleIterator`, estimated pattern cardinality), where
@@ -75,6 +95,10 @@ const char *HDT_DOCUMENT_SEARCH_TRIPLES_DOC = R"(
       for triple in triples:
         print(triple)
 
+      # Fetch all english labels
+      (triples, cardinality) = document.search_triples("", "http://www.w3.org/2000/01/rdf-schema#label", "",
+                                                       filters=[("object", "lang", "en")])
+
 )";
 
 const char *HDT_DOCUMENT_SEARCH_TRIPLES_IDS_DOC = R"(
@@ -89,6 +113,7 @@ const char *HDT_DOCUMENT_SEARCH_TRIPLES_IDS_DOC = R"(
     - obj ``str``: The object of the triple pattern ot seach for.
     - limit ``int`` ``optional``: Maximum number of triples to search for.
     - offset ``int`` ``optional``: Number of matching triples to skip before returning results.
+    - filters ``list`` ``optional``: Filters that matching triples must pass, as in :meth:`hdt.HDTDocument.search_triples`.
 
   Return:
     A 2-elements ``tuple`` (:class:`hdt.TripleIDIterator`, estimated pattern cardinality), where
@@ -110,6 +135,441 @@ const char *HDT_DOCUMENT_SEARCH_TRIPLES_IDS_DOC = R"(
 
 )";
 
+const char *HDT_DOCUMENT_CONTAINS_DOC = R"(
+  Test if the HDT document contains a RDF triple matching a triple pattern, without creating any iterator.
+  The triple pattern is made either of RDF terms, where empty strings are variables,
+  or of unique ids, where 0 is a variable.
+
+  Args:
+    - subject ``str`` or ``int``: The subject of the triple pattern.
+    - predicate ``str`` or ``int``: The predicate of the triple pattern.
+    - obj ``str`` or ``int``: The object of the triple pattern.
+
+  Return:
+    True if a RDF triple matches the triple pattern, False otherwise.
+)";
+
+const char *HDT_DOCUMENT_CONTAINS_MANY_DOC = R"(
+  Vectorized version of :meth:`hdt.HDTDocument.contains`, for triple patterns made of unique ids.
+  Triple patterns sharing the same subject and predicate are checked together, by scanning
+  their adjacency list once, and groups of triple patterns are checked in parallel.
+
+  Args:
+    - patterns: A numpy array of shape (n, 3) of triple patterns made of unique ids, where 0 is a variable.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    A numpy array of n booleans, True where a RDF triple matches the triple pattern.
+)";
+
+const char *HDT_DOCUMENT_OUT_DEGREE_DOC = R"(
+  Get the number of outgoing edges, i.e., of RDF triples whose subject is the node, for an array of nodes.
+  Nodes are identified by their global ids, where subjects and objects share the same id space:
+  shared subject-objects first, then subjects, then objects.
+  Degrees are read from the HDT indexes, without reading the matching RDF triples.
+
+  Args:
+    - ids: A numpy array of node global ids.
+    - predicate ``int`` ``optional``: Only count edges labelled by this predicate id, or 0 to count all edges.
+    - cache ``bool`` ``optional``: If True, compute the degrees of all nodes in a single scan, and reuse them in later calls. Ignored when a predicate is given.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+    - cache_path ``str`` ``optional``: With ``cache``, store the degrees in this file, which is mapped in memory and shared between
+      the processes using the same file. The file is built if it is missing or was built for another HDT file.
+
+  Return:
+    A numpy array of degrees, one per node. Nodes which are never subjects have a degree of 0.
+)";
+
+const char *HDT_DOCUMENT_IN_DEGREE_DOC = R"(
+  Get the number of incoming edges, i.e., of RDF triples whose object is the node, for an array of nodes.
+  Nodes are identified by their global ids, as in :meth:`hdt.HDTDocument.out_degree`.
+
+  Args:
+    - ids: A numpy array of node global ids.
+    - predicate ``int`` ``optional``: Only count edges labelled by this predicate id, or 0 to count all edges.
+    - cache ``bool`` ``optional``: If True, compute the degrees of all nodes in a single scan, and reuse them in later calls. Ignored when a predicate is given.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+    - cache_path ``str`` ``optional``: With ``cache``, store the degrees in this file, which is mapped in memory and shared between
+      the processes using the same file. The file is built if it is missing or was built for another HDT file.
+
+  Return:
+    A numpy array of degrees, one per node. Nodes which are never objects have a degree of 0.
+)";
+
+const char *HDT_DOCUMENT_NEIGHBORS_DOC = R"(
+  Get the adjacency lists of an array of nodes, identified by their global ids (see :meth:`hdt.HDTDocument.out_degree`).
+  Adjacency lists are read from the HDT indexes in parallel, and returned in CSR format.
+
+  Args:
+    - ids: A numpy array of node global ids.
+    - direction ``str`` ``optional``: Follow outgoing edges ("out"), incoming edges ("in") or both ("both").
+    - predicates ``list`` ``optional``: Only follow edges labelled by these predicate ids. By default, follow all edges.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    A tuple (indptr, neighbors, predicates) of numpy arrays, where the neighbors of the i-th node are
+    ``neighbors[indptr[i]:indptr[i + 1]]``, reached by edges labelled by ``predicates[indptr[i]:indptr[i + 1]]``.
+    With "both", outgoing edges come before incoming edges.
+
+  .. code-block:: python
+
+    from hdt import HDTDocument
+    import numpy as np
+    document = HDTDocument("test.hdt")
+
+    (indptr, neighbors, predicates) = document.neighbors(np.array([1, 2], dtype=np.uint32), direction="both")
+    for i in range(2):
+      print(neighbors[indptr[i]:indptr[i + 1]])
+)";
+
+const char *HDT_DOCUMENT_SAMPLE_TRIPLES_DOC = R"(
+  Draw RDF triples uniformly at random, with replacement, among the RDF triples matching a triple pattern.
+  When the HDT indexes give direct access to the matching triples, e.g., for patterns with a bound subject or
+  without any bound term, each triple is read in constant or logarithmic time, without scanning the triples before it.
+  Otherwise, the matching triples are counted with a first scan, then read with a second scan, on a single thread.
+
+  Args:
+    - n ``int``: Number of RDF triples to draw.
+    - pattern ``tuple`` ``optional``: A triple pattern (subject, predicate, object) made of unique ids, where 0 is a variable, or None to draw among all RDF triples.
+    - seed ``int`` ``optional``: Seed of the random number generator, or a negative value to use a random seed.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    A numpy array of shape (n, 3) of triple ids. Raise a ``RuntimeError`` if n > 0 and no RDF triple matches the triple pattern.
+)";
+
+const char *HDT_DOCUMENT_RANDOM_WALKS_DOC = R"(
+  Perform random walks over the RDF graph, e.g., to build DeepWalk or node2vec corpora.
+  Nodes are identified by their global ids (see :meth:`hdt.HDTDocument.out_degree`), and walks are
+  computed in parallel, each walk using its own random generator, so a given seed always gives the same walks.
+  A walk stops early when it reaches a node without any edge to follow.
+
+  Args:
+    - ids: A numpy array of global ids of the start nodes.
+    - walks_per_node ``int`` ``optional``: Number of walks from each start node.
+    - length ``int`` ``optional``: Number of nodes of each walk, including its start node.
+    - direction ``str`` ``optional``: Follow outgoing edges ("out"), incoming edges ("in") or both ("both").
+    - predicates ``list`` ``optional``: Only follow edges labelled by these predicate ids. By default, follow all edges.
+    - p ``float`` ``optional``: Node2vec return parameter. Lower values make walks return more often to the previous node.
+    - q ``float`` ``optional``: Node2vec in-out parameter. Lower values make walks move away from the previous node.
+    - seed ``int`` ``optional``: Seed of the random number generator, or a negative value to use a random seed.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    A numpy array of shape (len(ids) * walks_per_node, length), where the row ``i * len(ids) + j`` is the i-th walk
+    from the j-th start node. Walks which stop early are padded with 0.
+)";
+
+const char *HDT_DOCUMENT_WRITE_RANDOM_WALKS_DOC = R"(
+  Same as :meth:`hdt.HDTDocument.random_walks`, but write the walks in a text file, one walk per line,
+  as global ids separated by spaces. Walks are computed and written by batches, so large corpora do not need to fit in memory.
+
+  Args:
+    - path ``str``: Path of the output file.
+    - ids: A numpy array of global ids of the start nodes.
+    - walks_per_node ``int`` ``optional``: Number of walks from each start node.
+    - length ``int`` ``optional``: Maximum number of nodes of each walk, including its start node.
+    - direction ``str`` ``optional``: Follow outgoing edges ("out"), incoming edges ("in") or both ("both").
+    - predicates ``list`` ``optional``: Only follow edges labelled by these predicate ids. By default, follow all edges.
+    - p ``float`` ``optional``: Node2vec return parameter.
+    - q ``float`` ``optional``: Node2vec in-out parameter.
+    - seed ``int`` ``optional``: Seed of the random number generator, or a negative value to use a random seed.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    The number of walks written.
+)";
+
+const char *HDT_DOCUMENT_NEGATIVE_SAMPLES_DOC = R"(
+  Draw corrupted RDF triples, e.g., to train knowledge graph embeddings, by replacing the subject or the object of
+  triples with entities drawn uniformly at random from the subjects or the objects of the HDT dictionary.
+  Triples are processed in parallel, each one using its own random generator, so a given seed always gives the same samples.
+
+  Args:
+    - positives: A numpy array of shape (n, 3) of triple ids, e.g., from :meth:`hdt.HDTDocument.sample_triples`. Ids must be non-zero ids of the HDT dictionary.
+    - k ``int`` ``optional``: Number of corrupted triples per triple.
+    - mode ``str`` ``optional``: Replace subjects ("head") or objects ("tail").
+    - filtered ``bool`` ``optional``: If True, reject corrupted triples found in the HDT document, so only true negatives are returned.
+    - seed ``int`` ``optional``: Seed of the random number generator, or a negative value to use a random seed.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    A numpy array of shape (n * k, 3) of triple ids, where rows ``i * k`` to ``(i + 1) * k`` are the corrupted
+    triples of the i-th triple. Raise a ``RuntimeError`` if no negative of a triple can be found after 100 draws.
+)";
+
+const char *HDT_DOCUMENT_COMPUTE_HOPS_ARRAYS_DOC = R"(
+  Same as ``compute_hops``, but return numpy arrays instead of Python lists of tuples. Arrays share the memory
+  of the hop computation without any copy, so they can be passed directly to ``scipy.sparse.coo_matrix``.
+
+  Args:
+    - terms ``list``: Ids of the start terms.
+    - limit ``int``: Maximum number of triples to read (only for ``compute_hops_arrays``).
+    - offset ``int``: Number of triples to skip (only for ``compute_hops_arrays``).
+
+  Return:
+    A tuple (entities, predicates, adjacency), where ``entities`` maps local ids to global ids, ``predicates`` holds
+    the predicate ids, and ``adjacency[i]`` is a tuple (rows, cols) of arrays of local ids, for the edges labelled by ``predicates[i]``.
+
+  .. code-block:: python
+
+    from hdt import HDTDocument
+    from scipy.sparse import coo_matrix
+    import numpy as np
+    document = HDTDocument("test.hdt")
+    document.configure_hops(1, [], "", True, False)
+
+    (entities, predicates, adjacency) = document.compute_all_hops_arrays([1])
+    for (rows, cols) in adjacency:
+      matrix = coo_matrix((np.ones(len(rows)), (rows, cols)), shape=(len(entities), len(entities)))
+)";
+
+const char *HDT_DOCUMENT_PROPAGATE_DOC = R"(
+  Propagate activations over the subgraph reachable from a list of terms, as computed by ``compute_all_hops``
+  with the parameters set by ``configure_hops``. Edges are undirected, and weighted by the weight of their predicate.
+  Iterations are sparse matrix-vector products, computed in parallel without leaving C++.
+
+  Two modes are available:
+    - "ppr": personalized PageRank, where the random surfer teleports back to the seeds with probability alpha.
+    - "spread": spreading activation, where activations are summed over the weighted edges, then scaled so that the largest activation is 1.
+
+  Args:
+    - terms ``list``: Ids of the start terms of the hops.
+    - seeds ``list`` ``optional``: Global ids of the initially activated entities. By default, the start terms.
+    - weights ``dict`` ``optional``: Weight of the edges of each predicate id.
+    - default_weight ``float`` ``optional``: Weight of the edges of predicates missing from weights. Set it to 0 to only follow the predicates from weights.
+    - iterations ``int`` ``optional``: Number of iterations.
+    - mode ``str`` ``optional``: "ppr" or "spread".
+    - alpha ``float`` ``optional``: Teleport probability of personalized PageRank.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    A tuple (entities, activations) of numpy arrays, where ``activations[i]`` is the final activation of the entity
+    with the global id ``entities[i]``. Entities are in the same order as in ``compute_all_hops``.
+)";
+
+const char *HDT_DOCUMENT_CONFIGURE_HOPS_DOC = R"(
+  Configure the computation of hops by ``compute_hops`` and related methods.
+
+  Args:
+    - num_hops ``int``: Number of hops.
+    - predicates ``list``: Only follow triples with these predicate ids, or an empty list to follow all triples.
+    - prefix ``str``: Only follow triples towards terms with this prefix, or an empty string to follow all triples.
+    - continuous_dictionary ``bool``: If True, object ids are placed after subject ids, in a single id space.
+    - include_literals ``bool``: If True, also follow triples towards literals when a prefix is set.
+    - max_out_degree ``int`` ``optional``: Do not expand terms which are the subject of more triples, e.g., hubs like countries. 0 for no limit.
+    - max_in_degree ``int`` ``optional``: Do not expand terms which are the object of more triples, e.g., classes like ``wd:Q5``. 0 for no limit.
+    - truncate_hubs ``bool`` ``optional``: If True, expand only the first triples of terms above the limits, instead of skipping them.
+
+  Degrees are read from the HDT indexes, without reading the triples. The number of hubs found by the last
+  hop computation is available in :attr:`hdt.HDTDocument.nb_hubs`.
+)";
+
+const char *HDT_DOCUMENT_NB_HUBS_DOC = R"(
+  The number of hub expansions skipped or truncated by the last hop computation, due to the degree limits set by ``configure_hops``.
+  A term is counted once per direction.
+)";
+
+const char *HDT_DOCUMENT_CONFIGURE_HOP_CACHE_DOC = R"(
+  Enable a cache of the triples found around each term by ``compute_hops``, reused by later hop computations.
+  Entries depend on the predicate, prefix and literal filters set by ``configure_hops``, so changing the filters never
+  returns stale neighbourhoods. The least recently used entries are evicted when the cache is full.
+
+  Args:
+    - max_bytes ``int``: Maximum memory used by the cache, in bytes, or 0 to disable the cache.
+)";
+
+const char *HDT_DOCUMENT_HOP_CACHE_STATS_DOC = R"(
+  Get the counters of the cache of hop neighbourhoods.
+
+  Return:
+    A dict with the number of cache ``hits`` and ``misses``, the number of ``entries``, the ``bytes`` used and the ``capacity`` of the cache.
+)";
+
+const char *HDT_DOCUMENT_CLEAR_HOP_CACHE_DOC = R"(
+  Remove all entries from the cache of hop neighbourhoods, and reset its counters.
+)";
+
+const char *HDT_DOCUMENT_COMPUTE_HOPS_PAGED_DOC = R"(
+  Compute the triples reachable from a list of terms, with the parameters set by ``configure_hops``, and keep them
+  deduplicated and sorted by predicate, subject and object, so they can be read page by page.
+  Unlike ``compute_hops`` with a limit and an offset, the hops are computed once, and pages are stable and disjoint.
+
+  Args:
+    - terms ``list``: Ids of the start terms.
+
+  Return:
+    A :class:`hdt.HopResults` holding the sorted edges.
+
+  .. code-block:: python
+
+    from hdt import HDTDocument
+    document = HDTDocument("test.hdt")
+    document.configure_hops(2, [], "", True, False)
+
+    results = document.compute_hops_paged([1])
+    for offset in range(0, len(results), 100):
+      (predicates, rows, cols) = results.page(100, offset)
+)";
+
+const char *HDT_DOCUMENT_SAMPLE_NEIGHBORHOOD_DOC = R"(
+  Sample multi-layer neighborhoods of a batch of seed nodes, e.g., to build GraphSAGE mini-batches.
+  At each layer, up to ``fanouts[l]`` edges are drawn uniformly at random, without replacement, for each node of the layer,
+  by jumping to random positions of its adjacency lists in the HDT indexes. Nodes are identified by their global ids
+  (see :meth:`hdt.HDTDocument.out_degree`), and nodes of a layer are sampled in parallel.
+
+  Args:
+    - ids: A numpy array of global ids of the seed nodes.
+    - fanouts ``list``: Maximum number of edges drawn per node, for each layer, e.g., [15, 10].
+    - direction ``str`` ``optional``: Follow outgoing edges ("out"), incoming edges ("in") or both ("both").
+    - predicates ``list`` ``optional``: Only follow edges labelled by these predicate ids. By default, follow all edges.
+    - seed ``int`` ``optional``: Seed of the random number generator, or a negative value to use a random seed.
+    - threads ``int`` ``optional``: Number of threads, 0 to use all available cores.
+
+  Return:
+    A tuple (nodes, blocks), where ``nodes[0]`` holds the seeds, ``nodes[l + 1]`` holds the nodes of ``nodes[l]`` followed by
+    the new nodes sampled at layer l, and ``blocks[l]`` is a tuple (src, dst, predicates) of numpy arrays of the edges
+    sampled at layer l. ``src`` are local ids in ``nodes[l + 1]`` of the sampled neighbors, and ``dst`` are local ids in ``nodes[l]``
+    of the nodes they were sampled from.
+)";
+
+const char *HDT_DOCUMENT_LOAD_TYPE_INDEX_DOC = R"(
+  Load the sidecar index of the types of the entities, stored next to the HDT file and mapped in memory.
+  The index is opt-in: it is never built nor loaded unless this method is called.
+  The index is built first, by scanning the triples of the type predicates in parallel, if the index file does not exist
+  or was built for another HDT file or other type predicates. The index records the size and modification time of the
+  HDT file, so that it is rebuilt when the HDT file changes. Processes loading the same index share its memory.
+  Once loaded, the index is used by :meth:`hdt.HDTDocument.filter_types` and :meth:`hdt.HDTDocument.types_of`,
+  with its own type predicates.
+
+  Args:
+    - predicates ``list`` ``optional``: Type predicates, e.g., rdf:type or wdt:P31. Defaults to rdf:type.
+    - path ``str`` ``optional``: Path of the index file. Defaults to the path of the HDT file, with a ".types" suffix.
+    - threads ``int`` ``optional``: Number of threads used to build the index, 0 to use all available cores.
+
+  Return:
+    True if the index was built, False if an existing index was loaded.
+)";
+
+const char *HDT_DOCUMENT_TYPES_OF_DOC = R"(
+  Get the types of a batch of entities, in CSR format. Without a type index (see :meth:`hdt.HDTDocument.load_type_index`),
+  types are read from the triples of the rdf:type predicate.
+
+  Args:
+    - ids: A numpy array of global ids of the entities.
+
+  Return:
+    A tuple (indptr, types) of numpy arrays, where ``types[indptr[i]:indptr[i + 1]]`` are the sorted global ids of the
+    types of the i-th entity.
+)";
+
+const char *HDT_DOCUMENT_TO_GLOBAL_IDS_DOC = R"(
+  Convert a batch of ids to global ids, where shared subject-objects come first, then subjects, then objects,
+  so that a subject and an object with the same global id are the same RDF term. Predicate ids are unchanged.
+
+  Args:
+    - ids: A numpy array of ids of the dictionary.
+    - role ``TripleComponentRole``: Role of the ids, i.e., SUBJECT, PREDICATE or OBJECT.
+
+  Return:
+    A numpy array of global ids.
+)";
+
+const char *HDT_DOCUMENT_FROM_GLOBAL_IDS_DOC = R"(
+  Convert a batch of global ids (see :meth:`hdt.HDTDocument.to_global_ids`) back to ids of the dictionary.
+
+  Args:
+    - ids: A numpy array of global ids.
+
+  Return:
+    A tuple (ids, roles) of numpy arrays, where ``roles[i]`` is the ``TripleComponentRole`` value (SUBJECT or OBJECT)
+    under which ``ids[i]`` is found in the dictionary. Shared subject-objects are returned as subjects.
+)";
+
+const char *HDT_DOCUMENT_SEARCH_MANY_DOC = R"(
+  Search for RDF triples matching a batch of triple patterns, in a single call.
+  Patterns are evaluated sorted by subject and object, to improve locality in the HDT index,
+  and identical patterns are evaluated only once.
+
+  Args:
+    - patterns: Either a ``list`` of 3-elements ``tuple`` (subject, predicate, object), where empty strings
+      are variables, or a numpy array of shape (n, 3) of triple patterns made of unique ids, where 0 is a variable.
+    - limit ``int`` ``optional``: Maximum number of triples returned per pattern. 0 means "no limit".
+
+  Return:
+    A 2-elements ``tuple`` (offsets, triples) of numpy arrays, in CSR format: the IDs of the triples
+    matching the i-th pattern are ``triples[offsets[i]:offsets[i + 1]]``, an array of shape (k, 3).
+
+    .. code-block:: python
+
+      from hdt import HDTDocument
+      document = HDTDocument("test.hdt")
+
+      entities = ["http://example.org/s1", "http://example.org/s2"]
+      (offsets, triples) = document.search_many([(e, "http://xmlns.com/foaf/0.1/knows", "") for e in entities])
+      for i, entity in enumerate(entities):
+        print(entity, triples[offsets[i]:offsets[i + 1]])
+
+)";
+
+const char *HDT_DOCUMENT_SEARCH_JOIN_DOC = R"(
+  Evaluate a join between a set of triple patterns, i.e., a Basic Graph Pattern.
+  SPARQL variables are strings starting with ``?``.
+
+  Stars of triple patterns sharing the same subject variable, with constant predicates,
+  are evaluated by scanning the adjacency list of each candidate subject once.
+  Joins between large triple patterns are evaluated using hash joins.
+  When the hash table of a hash join exceeds ``memory_budget``, both inputs are
+  partitioned on disk and joined one partition at a time.
+
+  With ``threads`` greater than 1, the most selective triple pattern is split into ranges,
+  and each range is joined with the other patterns by a different thread.
+  In this case, solution bindings are returned in no particular order. The threads share
+  the hash tables, which are never partitioned on disk: ``memory_budget`` bounds the memory
+  of all hash joins together, and joins whose hash table would exceed it use index lookups.
+
+  With a ``limit`` or an ``offset``, the join is evaluated without hash joins nor threads,
+  so successive pages of solutions are returned in the same order. The join stops as soon
+  as ``limit`` solutions have been produced, so looking up the first answers stays cheap.
+
+  Args:
+    - patterns ``list``: The triple patterns to join, as 3-elements ``tuple`` (subject, predicate, object).
+    - memory_budget ``int`` ``optional``: Maximum memory used by each hash join, in bytes, or by all hash joins with several threads.
+    - threads ``int`` ``optional``: Number of threads used to evaluate the join, 0 to use all available cores.
+    - limit ``int`` ``optional``: Maximum number of solutions to return. 0 means "no limit".
+    - offset ``int`` ``optional``: Number of solutions to skip.
+    - filters ``list`` ``optional``: Filters on the variables of the join, as in :meth:`hdt.HDTDocument.search_triples`,
+      but targeting variables, e.g., ``("?name", "lang", "en")``. They are checked by the first triple pattern binding the variable.
+
+  Return:
+    A :class:`hdt.JoinIterator`, which iterates over solution bindings.
+    A set of solution bindings is a ``set`` of 2-elements ``tuple`` (variable, RDF term).
+
+    .. code-block:: python
+
+      from hdt import HDTDocument
+      document = HDTDocument("test.hdt")
+
+      join_iter = document.search_join([
+        ("?s", "http://xmlns.com/foaf/0.1/knows", "?x"),
+        ("?x", "http://xmlns.com/foaf/0.1/name", "?name")
+      ])
+
+      print("estimated join cardinality: %i" % len(join_iter))
+      for bindings in join_iter:
+        print(bindings)
+
+)";
+
+const char *HDT_DOCUMENT_CONFIGURE_JOINS_DOC = R"(
+  Configure the thresholds used to plan the joins of :meth:`hdt.HDTDocument.search_join`.
+
+  Args:
+    - hash_join_min_cardinality ``int`` ``optional``: Hash joins are only used when both of their inputs have at least this number of solutions.
+    - parallel_min_cardinality ``int`` ``optional``: With several threads, joins are only evaluated in parallel when their most selective
+      triple pattern has at least this number of solutions.
+)";
+
 const char *HDT_DOCUMENT_TRIPLES_IDS_TO_STRING_DOC = R"(
   Transform a RDF triple from a TripleID representation to a string representation.
 
@@ -156,6 +616,20 @@ const char *TRIPLE_ITERATOR_NEXT_DOC = R"(
   Return the next matching triple read by the iterator, or raise ``StopIterator`` if there is no more items to yield.
 )";
 
+const char *TRIPLE_ITERATOR_NEXT_BATCH_DOC = R"(
+  Return a ``list`` of up to ``n`` matching triples read by the iterator, or an empty list if there is no more items to yield.
+  This is much faster than reading the triples one by one.
+
+  In raw mode, return a 2-elements ``tuple`` (buffer, offsets), where buffer is a ``bytes`` object holding
+  the RDF terms of the batch, ordered subject, predicate, object for each triple, and the i-th term
+  is ``buffer[offsets[i]:offsets[i + 1]]``.
+)";
+
+const char *TRIPLE_ID_ITERATOR_NEXT_BATCH_DOC = R"(
+  Return up to ``n`` matching triples ids read by the iterator, as a numpy array of shape (k, 3) with k <= n,
+  or an empty array if there is no more items to yield. This is much faster than reading the triples one by one.
+)";
+
 const char *TRIPLE_ITERATOR_PEEK_DOC = R"(
   Return the next matching triple read by the iterator without advancing it, or raise ``StopIterator`` if there is no more items to yield.
 )";
@@ -203,4 +677,31 @@ const char *TRIPLE_ITERATOR_SIZE_DOC = R"(
 const char *TRIPLE_ITERATOR_ACC_ESTIMATION_DOC = R"(
   Return True if the iterator can accuratly estimate the cardinality of the triple pattern, False otherwise.
 )";
+const char *HOP_RESULTS_CLASS_DOC = R"(
+  The edges reachable from a list of terms, sorted by predicate, subject and object, as computed by :meth:`hdt.HDTDocument.compute_hops_paged`.
+  Subjects and objects are local ids, mapped to global ids by :attr:`entities`.
+)";
+
+const char *HOP_RESULTS_PAGE_DOC = R"(
+  Get a page of edges, in time proportional to the size of the page.
+
+  Args:
+    - limit ``int``: Maximum number of edges, or 0 to read all edges after the offset.
+    - offset ``int`` ``optional``: Number of edges to skip.
+
+  Return:
+    A tuple (predicates, rows, cols) of numpy arrays, with one entry per edge: its predicate id, and the local ids of its subject and object.
+)";
+
+const char *HOP_RESULTS_SIZE_DOC = R"(
+  Get the number of edges.
+
+  Return:
+    The number of edges.
+)";
+
+const char *HOP_RESULTS_ENTITIES_DOC = R"(
+  A numpy array of the global ids of the entities, indexed by local id.
+)";
+
 #endif /* PYHDT_DOCSTRINGS_HPP */
@@ -0,0 +1,108 @@
+/**
+ * global_id_mapping.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_GLOBAL_ID_MAPPING_HPP
+#define PYHDT_GLOBAL_ID_MAPPING_HPP
+
+#include <HDTEnums.hpp>
+#include <Dictionary.hpp>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * GlobalIDMapping converts HDT dictionary IDs into the "continuous" ID space,
+ * where shared subject-objects come first, then subjects, then objects.
+ * In this space, a subject and an object with the same global ID are the same
+ * RDF term, which allows to join subjects and objects on their IDs.
+ * Predicates keep their own ID space.
+ */
+struct GlobalIDMapping {
+  size_t nbShared;
+  size_t nbSubjects;
+
+  GlobalIDMapping() : nbShared(0), nbSubjects(0) {}
+
+  GlobalIDMapping(hdt::Dictionary *dict)
+      : nbShared(dict->getNshared()), nbSubjects(dict->getNsubjects()) {}
+
+  /*!
+   * Convert an HDT id to a global id
+   * @param  id   HDT id
+   * @param  role Role of the id in the dictionary
+   * @return      The global id
+   */
+  inline size_t toGlobal(size_t id, hdt::TripleComponentRole role) const {
+    if (role == hdt::OBJECT && id > nbShared) {
+      return id + (nbSubjects - nbShared);
+    }
+    return id;
+  }
+
+  /*!
+   * Convert a global id back to an HDT id for the given role.
+   * Returns 0 if the term cannot appear with this role.
+   * @param  id   Global id
+   * @param  role Role under which the id is used in a triple pattern
+   * @return      The HDT id, or 0
+   */
+  inline size_t fromGlobal(size_t id, hdt::TripleComponentRole role) const {
+    if (role == hdt::SUBJECT) {
+      return (id <= nbSubjects) ? id : 0;
+    } else if (role == hdt::OBJECT) {
+      if (id <= nbShared) {
+        return id;
+      }
+      return (id > nbSubjects) ? id - (nbSubjects - nbShared) : 0;
+    }
+    return id;
+  }
+
+  /*!
+   * Convert a batch of HDT ids with the same role to global ids.
+   * The loop is branch-free, so that it can be vectorized by the compiler.
+   * @param ids       HDT ids
+   * @param n         Number of ids
+   * @param role      Role of the ids in the dictionary
+   * @param globalIDs Output global ids, may be the same array as ids
+   */
+  inline void toGlobal(const unsigned int *ids, size_t n, hdt::TripleComponentRole role,
+                       unsigned int *globalIDs) const {
+    const unsigned int shared = (unsigned int) nbShared;
+    const unsigned int offset = (role == hdt::OBJECT) ? (unsigned int) (nbSubjects - nbShared) : 0;
+    for (size_t i = 0; i < n; i++) {
+      globalIDs[i] = ids[i] + ((ids[i] > shared) ? offset : 0);
+    }
+  }
+
+  /*!
+   * Convert a batch of global ids back to HDT ids, along with the role under which
+   * each id must be decoded (see decodingRole). The loop is branch-free.
+   * @param globalIDs Global ids
+   * @param n         Number of ids
+   * @param ids       Output HDT ids, may be the same array as globalIDs
+   * @param roles     Output roles, as hdt::TripleComponentRole values
+   */
+  inline void fromGlobal(const unsigned int *globalIDs, size_t n, unsigned int *ids,
+                         uint8_t *roles) const {
+    const unsigned int subjects = (unsigned int) nbSubjects;
+    const unsigned int offset = (unsigned int) (nbSubjects - nbShared);
+    for (size_t i = 0; i < n; i++) {
+      const bool isObject = globalIDs[i] > subjects;
+      roles[i] = isObject ? (uint8_t) hdt::OBJECT : (uint8_t) hdt::SUBJECT;
+      ids[i] = globalIDs[i] - (isObject ? offset : 0);
+    }
+  }
+
+  /*!
+   * Get the role under which a global id must be decoded by the dictionary
+   * @param  id Global id
+   * @return    hdt::OBJECT for objects which are not shared, hdt::SUBJECT otherwise
+   */
+  inline hdt::TripleComponentRole decodingRole(size_t id) const {
+    return (id > nbSubjects) ? hdt::OBJECT : hdt::SUBJECT;
+  }
+};
+
+#endif /* PYHDT_GLOBAL_ID_MAPPING_HPP */
@@ -0,0 +1,202 @@
+/**
+ * graph_view.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_GRAPH_VIEW_HPP
+#define PYHDT_GRAPH_VIEW_HPP
+
+#include "HDT.hpp"
+#include "global_id_mapping.hpp"
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Direction of the edges followed from a node
+enum EdgeDirection { OUTGOING, INCOMING, BOTH };
+
+/*!
+ * Parse a direction: "out", "in" or "both"
+ * @param  direction Name of the direction
+ * @return           Direction, or raise a runtime_error for an unknown name
+ */
+EdgeDirection parseDirection(const std::string &direction);
+
+/*!
+ * Sort a list of predicates used to filter edges, and remove duplicates and wildcards
+ * @param predicates Predicates of the edges to follow, where 0 is a wildcard
+ */
+void normalizePredicates(std::vector<unsigned int> &predicates);
+
+/*!
+ * SplitMix64 is a small and fast pseudo-random number generator. It is cheap
+ * to create, so each random walk can use its own generator, seeded from its
+ * index, which makes results independent of the number of threads.
+ */
+struct SplitMix64 {
+  uint64_t state;
+
+  SplitMix64(uint64_t seed) : state(seed) {}
+
+  inline uint64_t next() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Draw an integer in [0, n)
+  inline uint64_t below(uint64_t n) { return next() % n; }
+
+  // Draw a real in [0, 1)
+  inline double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+/*!
+ * Parameters of random walks. Node2vec biases are the return parameter p and
+ * the in-out parameter q: after a step from t to v, the next node x is drawn
+ * with a weight 1/p if x = t, 1 if x is a neighbor of t, and 1/q otherwise.
+ */
+struct WalkOptions {
+  // number of nodes of a walk, including its start node
+  size_t length;
+  EdgeDirection direction;
+  std::vector<unsigned int> predicates;
+  double p;
+  double q;
+};
+
+/*!
+ * Degrees of all nodes of the graph, indexed by global ID. The degrees are held
+ * either in memory, or in a file mapped in memory and shared between processes.
+ */
+struct DegreeTable {
+  size_t size;
+  const unsigned int *outDegrees;
+  const unsigned int *inDegrees;
+  // owner of the degrees: out-degrees then in-degrees, or a mapped degree file
+  std::vector<unsigned int> values;
+  std::shared_ptr<MappedFile> file;
+};
+
+/*!
+ * GraphView exposes the RDF graph of an HDT document as a directed multigraph,
+ * whose nodes are the subjects and objects, identified by their global IDs
+ * (see GlobalIDMapping), and whose edges are the triples, labelled by their
+ * predicates. Outgoing edges are read from the SPO index, and incoming edges
+ * from the object index. All methods are read-only, and can be called
+ * concurrently.
+ *
+ * hdt-cpp does not expose the BitmapTriples arrays nor their rank and select
+ * structures, so the graph operations read the indexes through
+ * Triples::search: adjacency ranges and degrees come from the exact
+ * cardinality estimates of the iterators, and ranges are split between
+ * threads with goTo when the iterator supports it.
+ */
+class GraphView {
+private:
+  hdt::HDT *hdt;
+  GlobalIDMapping mapping;
+
+  void appendEdges(hdt::TripleID &pattern, bool outgoing, std::vector<unsigned int> &neighbors,
+                   std::vector<unsigned int> &labels) const;
+
+public:
+  /*!
+   * Constructor
+   * @param _hdt HDT document, which must outlive the view
+   */
+  GraphView(hdt::HDT *_hdt);
+
+  /*!
+   * Get the largest global ID of a node
+   * @return Largest global ID of a subject or an object
+   */
+  size_t getMaxNodeID() const;
+
+  /*!
+   * Get the mapping between global IDs and HDT IDs
+   * @return Mapping of the HDT dictionary
+   */
+  GlobalIDMapping getMapping() const;
+
+  /*!
+   * Count the outgoing edges of a node
+   * @param  node      Global ID of the node
+   * @param  predicate Only count edges with this predicate, or 0 for all edges
+   * @return           Number of edges
+   */
+  size_t outDegree(size_t node, size_t predicate = 0) const;
+
+  /*!
+   * Count the incoming edges of a node
+   * @param  node      Global ID of the node
+   * @param  predicate Only count edges with this predicate, or 0 for all edges
+   * @return           Number of edges
+   */
+  size_t inDegree(size_t node, size_t predicate = 0) const;
+
+  /*!
+   * Append the neighbors of a node, and the predicates of the edges leading to them.
+   * Outgoing edges come first, sorted by predicate, then incoming edges.
+   * @param node       Global ID of the node
+   * @param direction  Direction of the edges to follow
+   * @param predicates Sorted predicates of the edges to follow, or empty to follow all edges
+   * @param neighbors  Global IDs of the neighbors
+   * @param labels     Predicates of the edges
+   */
+  void neighbors(size_t node, EdgeDirection direction, const std::vector<unsigned int> &predicates,
+                 std::vector<unsigned int> &neighbors, std::vector<unsigned int> &labels) const;
+
+  /*!
+   * Draw up to fanout edges of a node uniformly at random, without replacement, by
+   * jumping to random positions of its adjacency lists. All edges are kept when the
+   * node has at most fanout edges.
+   * @param  node       Global ID of the node
+   * @param  direction  Direction of the edges to follow
+   * @param  predicates Sorted predicates of the edges to follow, or empty to follow all edges
+   * @param  fanout     Maximum number of edges drawn
+   * @param  generator  Random generator of the caller
+   * @param  neighbors  Global IDs of the neighbors, with room for fanout nodes
+   * @param  labels     Predicates of the edges, with room for fanout predicates
+   * @return            Number of edges drawn
+   */
+  size_t sampleNeighbors(size_t node, EdgeDirection direction,
+                         const std::vector<unsigned int> &predicates, size_t fanout,
+                         SplitMix64 &generator, unsigned int *neighbors,
+                         unsigned int *labels) const;
+
+  /*!
+   * Perform a random walk, which stops early at nodes without any edge to follow.
+   * Each step draws a single edge with sampleNeighbors. Biased walks also read the
+   * neighbors of the previous node, for the node2vec rejection test.
+   * @param  start   Global ID of the start node
+   * @param  options Length, direction, predicates and node2vec parameters of the walk
+   * @param  seed    Seed of the random generator of the walk
+   * @param  walk    Global IDs of the nodes of the walk, with room for options.length nodes
+   * @return         Number of nodes of the walk
+   */
+  size_t randomWalk(size_t start, const WalkOptions &options, uint64_t seed,
+                    unsigned int *walk) const;
+
+  /*!
+   * Compute the degrees of all nodes, using a single scan of the triples
+   * @param table Output: the degrees, held in memory
+   */
+  void allDegrees(DegreeTable &table) const;
+
+  /*!
+   * Get the degrees of all nodes from a degree file, building the file first if
+   * it does not exist or was built for another graph. If the file cannot be
+   * written, the degrees are only kept in memory.
+   * @param  path    Path of the degree file
+   * @param  hdtFile Path of the HDT file of the graph, whose size and modification
+   *                 time identify the graph, or empty if the graph has no file
+   * @return         Degrees of all nodes
+   */
+  std::shared_ptr<DegreeTable> sharedDegrees(std::string path, std::string hdtFile) const;
+};
+
+#endif /* PYHDT_GRAPH_VIEW_HPP */
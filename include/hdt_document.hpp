@@ -8,12 +8,23 @@
 
 #include "HDT.hpp"
 #include "QueryProcessor.hpp"
+#include "array_utils.hpp"
+#include "graph_view.hpp"
+#include "hop_cache.hpp"
+#include "hop_results.hpp"
+#include "propagation.hpp"
 #include "pyhdt_types.hpp"
 #include "triple_iterator.hpp"
+#include "type_index.hpp"
 #include "triple_comparison.hpp"
 #include "tripleid_iterator.hpp"
 #include "join_iterator.hpp"
+#include "join_operators.hpp"
+#include "join_planner.hpp"
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -30,6 +41,48 @@ typedef std::tuple<TripleIterator *, size_t> search_results;
 // Same as seach_results, but for an iterator over triple ids
 typedef std::tuple<TripleIDIterator *, size_t> search_results_ids;
 
+// Triples ids matching a batch of triple patterns, in CSR format: a tuple (offsets, triples),
+// where the triples matching the i-th pattern are triples[offsets[i]:offsets[i + 1]]
+typedef std::tuple<py::array_t<uint64_t>, py::array_t<unsigned int>> csr_triples;
+
+// Adjacency lists of a batch of nodes, in CSR format: a tuple (indptr, neighbors, predicates),
+// where the edges of the i-th node are neighbors[indptr[i]:indptr[i + 1]], labelled by
+// predicates[indptr[i]:indptr[i + 1]]
+typedef std::tuple<py::array_t<uint64_t>, py::array_t<unsigned int>, py::array_t<unsigned int>> csr_adjacency;
+
+// Types of a batch of entities, in CSR format: a tuple (indptr, types), where the types
+// of the i-th entity are types[indptr[i]:indptr[i + 1]]
+typedef std::tuple<py::array_t<uint64_t>, py::array_t<unsigned int>> csr_types;
+
+// Output of a hop computation as numpy arrays: a tuple (local to global IDs, predicates, adjacency),
+// where adjacency[i] is a tuple (rows, cols) of local IDs, for the edges labelled by predicates[i]
+typedef std::tuple<py::array_t<unsigned int>, py::array_t<unsigned int>,
+                   std::vector<std::tuple<py::array_t<unsigned int>, py::array_t<unsigned int>>>> hop_arrays;
+
+// Neighborhoods sampled for a batch of seed nodes: a tuple (nodes, blocks), where nodes[0] are the
+// seeds, nodes[l + 1] extends nodes[l] with the neighbors sampled at layer l, and blocks[l] is a tuple
+// (src, dst, predicates) of the edges of layer l, from local IDs in nodes[l + 1] to local IDs in nodes[l]
+typedef std::tuple<std::vector<py::array_t<unsigned int>>,
+                   std::vector<std::tuple<py::array_t<unsigned int>, py::array_t<unsigned int>, py::array_t<unsigned int>>>> sampled_neighborhood;
+
+/*!
+ * An HDT file mapped by this process, with its query processor and the lock of
+ * its dictionary, shared by the documents opened on this file and freed with the last of them
+ */
+struct OpenedHDT {
+  hdt::HDT *hdt;
+  hdt::QueryProcessor *processor;
+  std::shared_ptr<std::mutex> decodeMutex;
+
+  OpenedHDT(hdt::HDT *_hdt, hdt::QueryProcessor *_processor)
+      : hdt(_hdt), processor(_processor), decodeMutex(std::make_shared<std::mutex>()) {}
+
+  ~OpenedHDT() {
+    delete processor;
+    delete hdt;
+  }
+};
+
 /*!
  * HDTDocument is the main entry to manage an hdt document
  * \author Thomas Minier
@@ -39,6 +92,12 @@ private:
   std::string hdt_file;
   hdt::HDT *hdt;
   hdt::QueryProcessor *processor;
+  // serializes the calls to the dictionary, whose sections decode terms lazily and
+  // without locks, and to the processor. Shared with the iterators, the copies and
+  // the other documents opened on hdt_file.
+  std::shared_ptr<std::mutex> decodeMutex;
+  // mapping of hdt_file, shared with the other documents opened on this file
+  std::shared_ptr<OpenedHDT> openedFile;
   HDTDocument(std::string file);
 
 /*!
@@ -51,11 +110,130 @@ private:
    */
 void addhop(size_t termID,int currenthop,hdt::TripleComponentRole role,unsigned int limit, unsigned int offset);
 
+  /*!
+   * Process a triple found around a term during a hop, and continue the hops from its other end
+   * @param triple
+   * @param next the other end of the triple
+   * @param nextRole role of the other end of the triple
+   * @param currenthop
+   * @param limit
+   * @param offset
+   */
+  void visitHopTriple(hdt::TripleID &triple, size_t next, hdt::TripleComponentRole nextRole,
+                      int currenthop, unsigned int limit, unsigned int offset);
+
+  /*!
+   * Get the triples around a term which pass the hop filters, from the hop cache if possible
+   * @param termID
+   * @param role
+   */
+  hop_neighbourhood hopNeighbourhood(size_t termID, hdt::TripleComponentRole role, size_t maxTriples);
+
+  /*!
+   * Build the hop filters and their hash from the hop configuration
+   */
+  void updateHopFilters();
+
+  /*!
+   * Check if a term can be expanded in a direction, given the degree limits
+   * @param termID
+   * @param role
+   * @param maxTriples set to the maximum number of triples to read, 0 for all triples
+   * @return False if the term is a hub which must not be expanded
+   */
+  bool canExpand(size_t termID, hdt::TripleComponentRole role, size_t &maxTriples);
+
+  /*!
+   * Compute the reachable triples from the given terms, and keep them in outtriplesSet
+   * @param terms
+   * @param limit
+   * @param offset
+   */
+  void collectHops(vector<unsigned int> &terms, unsigned int limit, unsigned int offset);
+
+  /*!
+   * Build the adjacency matrix of each predicate from outtriplesSet, with local IDs
+   * @param mappingLocalToGlobalID
+   * @param predicates
+   * @param rows local IDs of the subjects of each predicate
+   * @param cols local IDs of the objects of each predicate
+   */
+  void buildHopMatrix(vector<unsigned int> &mappingLocalToGlobalID, vector<unsigned int> &predicates,
+                      vector<vector<unsigned int>> &rows, vector<vector<unsigned int>> &cols);
+
   /*!
    * Output the result of the hop, in outtriples
    */
   std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<unsigned int, unsigned int>>>> outputMatrix();
 
+  /*!
+   * Evaluate a batch of triple patterns made of IDs, and group the matching
+   * triples by pattern in CSR format
+   * @param patterns Triple patterns made of IDs, where 0 is a variable
+   * @param valid    False for patterns which cannot match, e.g., with unknown RDF terms
+   * @param limit    Maximum number of triples per pattern, 0 for no limit
+   * @param offsets  Output: the triples of pattern i are the rows offsets[i] to offsets[i + 1] - 1
+   * @param triples  Output: the matching triples, 3 IDs per triple
+   */
+  void evaluateMany(std::vector<hdt::TripleID> &patterns, std::vector<bool> &valid,
+                    unsigned int limit, std::vector<uint64_t> &offsets,
+                    std::vector<unsigned int> &triples);
+
+  /*!
+   * Check the existence of a group of triple patterns sharing the same subject
+   * and predicate, found at positions [first, last) of order
+   * @param probes  Triple patterns made of IDs
+   * @param order   Indexes of the probes, sorted by subject, predicate and object
+   * @param first   Position in order of the first probe of the group
+   * @param last    Position in order following the last probe of the group
+   * @param results Output: 1 for the probes which match a triple, 0 otherwise
+   */
+  void probeGroup(std::vector<hdt::TripleID> &probes, std::vector<size_t> &order,
+                  size_t first, size_t last, std::vector<uint8_t> &results);
+
+  /*!
+   * Compute the out-degrees or in-degrees of an array of nodes
+   * @param ids       Global IDs of the nodes
+   * @param predicate Only count edges with this predicate, or 0 for all edges
+   * @param cache     If True, read the degrees from a table of the degrees of all nodes
+   * @param threads   Number of threads, 0 to use all hardware threads
+   * @param cachePath If not empty, store the cached degrees in this file, shared between processes
+   * @param outgoing  True for out-degrees, False for in-degrees
+   */
+  py::array_t<unsigned int> degrees(py::array_t<unsigned int> ids, unsigned int predicate,
+                                    bool cache, int threads, std::string cachePath, bool outgoing);
+
+  /*!
+   * Read the triples at sorted positions [begin, end) of draws, in the triples matching a
+   * triple pattern, and write them at the index paired with each position
+   * @param pattern    Triple pattern made of IDs
+   * @param draws      Pairs (position, index), sorted by position
+   * @param begin      First draw read
+   * @param end        Draw following the last draw read
+   * @param positional If True, jump to positions, otherwise read all triples up to them
+   * @param results    Output: 3 IDs per draw, at the index of the draw
+   */
+  void readPositions(hdt::TripleID pattern, std::vector<std::pair<size_t, size_t>> &draws,
+                     size_t begin, size_t end, bool positional, std::vector<unsigned int> &results);
+
+  /*!
+   * Perform the random walks [first, last), and write them in walks
+   * @param nodes        Start nodes
+   * @param first        Index of the first walk
+   * @param last         Index following the last walk
+   * @param options      Length, direction, predicates and node2vec parameters of the walks
+   * @param seed         Base seed: walk i uses a generator seeded from seed and i
+   * @param threads      Number of threads, 0 to use all hardware threads
+   * @param walks        Walks, padded with 0, with room for (last - first) * options.length nodes
+   * @param sizes        Number of nodes of each walk
+   */
+  void runWalks(std::vector<unsigned int> &nodes, size_t first, size_t last,
+                WalkOptions &options, uint64_t seed, int threads,
+                std::vector<unsigned int> &walks, std::vector<size_t> &sizes);
+
+  // degrees of all nodes, computed on demand and shared between copies
+  std::shared_ptr<DegreeTable> degreeCache;
+
   int numHops;
   string filterPrefixStr;
   bool continuousDictionary;
@@ -72,6 +250,21 @@ void addhop(size_t termID,int currenthop,hdt::TripleComponentRole role,unsigned
   unsigned int preffixEndOBJECT;
   unsigned int literalEndID;
   bool includeLiterals;
+  // cache of hop neighbourhoods, shared between copies, and hash of the hop filters
+  std::shared_ptr<HopCache> hopCache;
+  size_t hopConfigHash;
+  std::shared_ptr<const HopFilters> hopFilters;
+  // degree limits of hop expansion, and number of hubs found
+  size_t maxOutDegree;
+  size_t maxInDegree;
+  bool truncateHubs;
+  size_t nbHubs;
+  // minimum cardinality of both inputs of a hash join in searchJoin
+  size_t hashJoinMinCardinality;
+  // minimum cardinality of the driving pattern of a parallel join in searchJoin
+  size_t parallelMinCardinality;
+  // sidecar index of the types of the entities, shared between copies
+  std::shared_ptr<TypeIndex> typeIndex;
 
   // Declaring unordered_set of TripleID
    std::unordered_set<hdt::TripleID, TripleIDHasher,TripleIDComparator> outtriplesSet;
@@ -138,6 +331,23 @@ public:
    */
   static HDTDocument create(std::string file) { return HDTDocument(file); }
 
+  /*!
+   * Get the state of the document, used to pickle it: the path of the HDT file,
+   * the hop configuration with its literal and prefix ID ranges, the capacity of the
+   * hop cache, the path of the type index and the join thresholds
+   * @return Tuple of the state
+   */
+  py::tuple getState();
+
+  /*!
+   * Reopen a pickled document, reusing the mapping of its HDT file and of its
+   * type index if this process already opened them. The ID ranges of the hop
+   * configuration are restored from the state, without scanning the dictionary.
+   * @param  state State returned by getState
+   * @return       The document
+   */
+  static HDTDocument fromState(py::tuple state);
+
   /*!
    * Convert a TripleID to a string triple pattern
    * @param  subject   [description]
@@ -149,17 +359,22 @@ public:
                      unsigned int object);
 
   /*!
-   * Search all matching triples for a triple pattern, whith an optional limit
-   * and offset. Returns a tuple<TripleIterator*, cardinality>
+   * Search all matching triples for a triple pattern, whith an optional limit,
+   * offset and filters. Returns a tuple<TripleIterator*, cardinality>
    * @param subject   [description]
    * @param predicate [description]
    * @param object    [description]
    * @param limit     [description]
    * @param offset    [description]
+   * @param filters   Filters on the "subject", "predicate" or "object" of matching triples
+   * @param prefetch  If > 0, decode up to prefetch triples ahead in a background thread
+   * @param raw       If True, RDF terms are returned to Python as bytes
    */
   search_results search(std::string subject, std::string predicate,
                         std::string object, unsigned int limit = 0,
-                        unsigned int offset = 0);
+                        unsigned int offset = 0,
+                        std::vector<filter_expr> filters = std::vector<filter_expr>(),
+                        size_t prefetch = 0, bool raw = false);
 
   /*!
    * Same as search, but for an iterator over TripleIDs.
@@ -169,12 +384,183 @@ public:
    * @param object    [description]
    * @param limit     [description]
    * @param offset    [description]
+   * @param filters   Filters on the triple positions
    */
   search_results_ids searchIDs(std::string subject, std::string predicate,
                                std::string object, unsigned int limit = 0,
-                               unsigned int offset = 0);
+                               unsigned int offset = 0,
+                               std::vector<filter_expr> filters = std::vector<filter_expr>());
+
+  /*!
+   * Configure the thresholds used by the join planner of searchJoin
+   * @param setHashJoinMinCardinality Minimum cardinality of both inputs of a hash join
+   * @param setParallelMinCardinality Minimum cardinality of the driving pattern of a parallel join
+   */
+  void configureJoins(size_t setHashJoinMinCardinality = HASH_JOIN_MIN_CARDINALITY,
+                      size_t setParallelMinCardinality = PARALLEL_MIN_CARDINALITY);
 
-  JoinIterator * searchJoin(std::vector<triple> patterns);
+  /*!
+   * Search a batch of triple patterns in a single call. Empty strings are variables.
+   * Returns the matching triples ids, grouped by pattern in CSR format.
+   * @param patterns Triple patterns, as (subject, predicate, object)
+   * @param limit    Maximum number of triples per pattern, 0 for no limit
+   */
+  csr_triples searchMany(std::vector<triple> patterns, unsigned int limit = 0);
+
+  /*!
+   * Same as searchMany, but for an array of shape (n, 3) of triple patterns
+   * made of IDs, where 0 is a variable.
+   * @param patterns Array of shape (n, 3) of triple patterns made of IDs
+   * @param limit    Maximum number of triples per pattern, 0 for no limit
+   */
+  csr_triples searchManyIDs(py::array_t<unsigned int> patterns, unsigned int limit = 0);
+
+  /*!
+   * Test if the HDT document contains a triple matching a triple pattern.
+   * Empty strings are variables.
+   * @param subject   Subject of the pattern, or an empty string for a variable
+   * @param predicate Predicate of the pattern, or an empty string for a variable
+   * @param object    Object of the pattern, or an empty string for a variable
+   */
+  bool contains(std::string subject, std::string predicate, std::string object);
+
+  /*!
+   * Same as contains, but for a triple pattern made of IDs, where 0 is a variable
+   * @param subject   Subject ID of the pattern, or 0 for a variable
+   * @param predicate Predicate ID of the pattern, or 0 for a variable
+   * @param object    Object ID of the pattern, or 0 for a variable
+   */
+  bool containsIDs(unsigned int subject, unsigned int predicate, unsigned int object);
+
+  /*!
+   * Vectorized version of containsIDs, for an array of shape (n, 3) of triple patterns
+   * @param patterns Array of shape (n, 3) of triple patterns made of IDs, where 0 is a variable
+   * @param threads  Number of threads, 0 to use all hardware threads
+   */
+  py::array_t<bool> containsMany(py::array_t<unsigned int> patterns, int threads = 0);
+
+  /*!
+   * Get the number of outgoing edges of an array of nodes
+   * @param ids       Global IDs of the nodes
+   * @param predicate Only count edges with this predicate, or 0 for all edges
+   * @param cache     If True, compute the degrees of all nodes once, and reuse them later
+   * @param threads   Number of threads, 0 to use all hardware threads
+   * @param cachePath If not empty, store the cached degrees in this file, shared between processes
+   */
+  py::array_t<unsigned int> outDegree(py::array_t<unsigned int> ids, unsigned int predicate = 0,
+                                      bool cache = false, int threads = 0, std::string cachePath = "");
+
+  /*!
+   * Get the number of incoming edges of an array of nodes
+   * @param ids       Global IDs of the nodes
+   * @param predicate Only count edges with this predicate, or 0 for all edges
+   * @param cache     If True, compute the degrees of all nodes once, and reuse them later
+   * @param threads   Number of threads, 0 to use all hardware threads
+   * @param cachePath If not empty, store the cached degrees in this file, shared between processes
+   */
+  py::array_t<unsigned int> inDegree(py::array_t<unsigned int> ids, unsigned int predicate = 0,
+                                     bool cache = false, int threads = 0, std::string cachePath = "");
+
+  /*!
+   * Get the adjacency lists of an array of nodes
+   * @param ids        Global IDs of the nodes
+   * @param direction  "out", "in" or "both"
+   * @param predicates Only follow edges with these predicates, or empty to follow all edges
+   * @param threads    Number of threads, 0 to use all hardware threads
+   */
+  csr_adjacency neighbors(py::array_t<unsigned int> ids, std::string direction = "out",
+                          std::vector<unsigned int> predicates = std::vector<unsigned int>(),
+                          int threads = 0);
+
+  /*!
+   * Draw triples uniformly at random, with replacement, among the triples matching a
+   * triple pattern made of IDs, where 0 is a variable.
+   * Raise a runtime_error if n > 0 and no triple matches the pattern.
+   * @param n       Number of triples to draw
+   * @param pattern Triple pattern (subject, predicate, object), or None for all triples
+   * @param seed    Seed of the random generator, or a negative value for a random seed
+   * @param threads Number of threads, 0 to use all hardware threads
+   */
+  py::array_t<unsigned int> sampleTriples(size_t n, py::object pattern = py::none(),
+                                          long long seed = -1, int threads = 0);
+
+  /*!
+   * Perform random walks from an array of start nodes. The walk i * len(ids) + j
+   * is the i-th walk from the j-th node, and walks shorter than length are padded with 0.
+   * @param ids          Global IDs of the start nodes
+   * @param walksPerNode Number of walks from each start node
+   * @param length       Number of nodes of each walk, including its start node
+   * @param direction    "out", "in" or "both"
+   * @param predicates   Only follow edges with these predicates, or empty to follow all edges
+   * @param p            Node2vec return parameter
+   * @param q            Node2vec in-out parameter
+   * @param seed         Seed of the random generator, or a negative value for a random seed
+   * @param threads      Number of threads, 0 to use all hardware threads
+   */
+  py::array_t<unsigned int> randomWalks(py::array_t<unsigned int> ids, size_t walksPerNode = 1,
+                                        size_t length = 10, std::string direction = "out",
+                                        std::vector<unsigned int> predicates = std::vector<unsigned int>(),
+                                        double p = 1.0, double q = 1.0, long long seed = -1,
+                                        int threads = 0);
+
+  /*!
+   * Same as randomWalks, but write the walks in a text file, one walk per line
+   * @param path Path of the text file
+   * @return     Number of walks written
+   */
+  size_t writeRandomWalks(std::string path, py::array_t<unsigned int> ids, size_t walksPerNode = 1,
+                          size_t length = 10, std::string direction = "out",
+                          std::vector<unsigned int> predicates = std::vector<unsigned int>(),
+                          double p = 1.0, double q = 1.0, long long seed = -1, int threads = 0);
+
+  /*!
+   * Draw corrupted triples from an array of shape (n, 3) of triples made of IDs, by
+   * replacing their subject or their object with random subjects or objects.
+   * Raise a runtime_error if a triple is not made of IDs of the dictionary, or if
+   * no negative of a triple is found after NEGATIVE_SAMPLES_MAX_ATTEMPTS draws.
+   * @param positives Array of shape (n, 3) of triples made of IDs
+   * @param k         Number of corrupted triples per triple
+   * @param mode      "head" to replace subjects, "tail" to replace objects
+   * @param filtered  If True, only keep corrupted triples absent from the HDT document
+   * @param seed      Seed of the random generator, or a negative value for a random seed
+   * @param threads   Number of threads, 0 to use all hardware threads
+   */
+  py::array_t<unsigned int> negativeSamples(py::array_t<unsigned int> positives, size_t k = 1,
+                                            std::string mode = "tail", bool filtered = true,
+                                            long long seed = -1, int threads = 0);
+
+  /*!
+   * Sample multi-layer neighborhoods of a batch of seed nodes, drawing a fixed number
+   * of edges per node and per layer
+   * @param ids        Global IDs of the seed nodes
+   * @param fanouts    Number of edges drawn per node, for each layer
+   * @param direction  "out", "in" or "both"
+   * @param predicates Only follow edges with these predicates, or empty to follow all edges
+   * @param seed       Seed of the random generator, or a negative value for a random seed
+   * @param threads    Number of threads, 0 to use all hardware threads
+   */
+  sampled_neighborhood sampleNeighborhood(py::array_t<unsigned int> ids, std::vector<size_t> fanouts,
+                                          std::string direction = "out",
+                                          std::vector<unsigned int> predicates = std::vector<unsigned int>(),
+                                          long long seed = -1, int threads = 0);
+
+  /*!
+   * Evaluate a join between triple patterns. Variables are strings starting with '?'.
+   * Joins over large inputs are evaluated with hash joins, which use at most
+   * memoryBudget bytes of memory before partitioning their inputs on disk.
+   * With threads > 1, the driving pattern is partitioned between worker threads.
+   * With a limit, the join stops as soon as enough solutions have been produced.
+   * @param patterns     Triple patterns of the join
+   * @param memoryBudget Memory budget of each hash join, in bytes, or of all hash joins with threads > 1
+   * @param threads      Number of worker threads, 0 to use all hardware threads
+   * @param limit        Maximum number of solutions to produce, 0 for no limit
+   * @param offset       Number of solutions to skip
+   * @param filters      Filters on the join variables
+   */
+  JoinIterator * searchJoin(std::vector<triple> patterns,
+                            size_t memoryBudget = HASH_JOIN_DEFAULT_MEMORY_BUDGET,
+                            int threads = 1, size_t limit = 0, size_t offset = 0,
+                            std::vector<filter_expr> filters = std::vector<filter_expr>());
 
 
  /*!
@@ -184,8 +570,17 @@ public:
    * @param setfilterPrefixStr only consider entities with the given prefix, set "" for all
    * @param setcontinuousDictionary Output the result using a continuous mapping (object IDs after subjects) instead of the traditional HDT dictionary (default true)
    * @param setincludeLiterals Include literals in the computation on hops
+   * @param setmaxOutDegree Do not expand terms with more outgoing triples, 0 for no limit
+   * @param setmaxInDegree Do not expand terms with more incoming triples, 0 for no limit
+   * @param settruncateHubs Expand only the first triples of terms above the limits, instead of skipping them
    */
-  void configureHops(int setnumHops,vector<unsigned int> filterPredicates,string setfilterPrefixStr,bool setcontinuousDictionary, bool setincludeLiterals);
+  void configureHops(int setnumHops,vector<unsigned int> filterPredicates,string setfilterPrefixStr,bool setcontinuousDictionary, bool setincludeLiterals,
+                     size_t setmaxOutDegree = 0, size_t setmaxInDegree = 0, bool settruncateHubs = false);
+
+  /*!
+   * Get the number of hub expansions skipped or truncated by the last hop computation
+   */
+  size_t getNbHubs();
 
   /*!
    * Compute the reachable triples from the given terms, in the configure number of numHops.
@@ -199,6 +594,62 @@ public:
      */
     std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<unsigned int, unsigned int>>>> computeHopsIDs(vector<unsigned int> terms, unsigned int limit, unsigned int offset);
 
+  /*!
+   * Compute the reachable triples from the given terms, in the configured number of hops,
+   * and keep them sorted, so they can be read page by page
+   * @param terms
+   */
+  HopResults * computeHopsPaged(vector<unsigned int> terms);
+
+  /*!
+   * Enable the cache of hop neighbourhoods, reused across hop computations
+   * @param maxBytes maximum memory used by the cache, or 0 to disable it
+   */
+  void configureHopCache(size_t maxBytes);
+
+  /*!
+   * Get the counters of the cache of hop neighbourhoods
+   */
+  std::map<std::string, size_t> hopCacheStats();
+
+  /*!
+   * Remove all neighbourhoods from the cache of hop neighbourhoods
+   */
+  void clearHopCache();
+
+  /*!
+   * Same as computeAllHopsIDs, but output numpy arrays instead of Python lists
+   * @param terms
+   */
+  hop_arrays computeAllHopsArrays(vector<unsigned int> terms);
+
+  /*!
+   * Same as computeHopsIDs, but output numpy arrays instead of Python lists
+   * @param terms
+   * @param limit
+   * @param offset
+   */
+  hop_arrays computeHopsArrays(vector<unsigned int> terms, unsigned int limit, unsigned int offset);
+
+  /*!
+   * Propagate activations over the subgraph reachable from the given terms, in the
+   * configured number of hops
+   * @param terms
+   * @param seeds global IDs of the initially activated entities, or empty to use terms
+   * @param weights weight of the edges of each predicate
+   * @param defaultWeight weight of the edges of the other predicates
+   * @param iterations
+   * @param mode "spread" for spreading activation, "ppr" for personalized PageRank
+   * @param alpha teleport probability of personalized PageRank
+   * @param threads number of threads, 0 to use all hardware threads
+   * @return a tuple (global IDs of the entities of the subgraph, activation of each entity)
+   */
+  std::tuple<py::array_t<unsigned int>, py::array_t<double>> propagate(vector<unsigned int> terms,
+      vector<unsigned int> seeds = vector<unsigned int>(),
+      std::map<unsigned int, double> weights = std::map<unsigned int, double>(),
+      double defaultWeight = 1.0, size_t iterations = 10, std::string mode = "ppr",
+      double alpha = 0.15, int threads = 0);
+
    /*!
      * Compute the reachable triples from the given terms, in the configure number of numHops.
      * @param terms
@@ -206,6 +657,25 @@ public:
      */
     vector<vector<unsigned int>> filterTypeIDs(vector<unsigned int> terms,vector<unsigned int> classes);
 
+  /*!
+   * Load the sidecar index of the types of the entities, building it first if the
+   * index file does not exist or was built for another HDT file or other type predicates.
+   * The index is opt-in: it is only used after a call to this method. Once loaded, the index is used by filterTypeIDs and typesOf.
+   * @param predicates type predicates, e.g., rdf:type
+   * @param path       path of the index file, by default the path of the HDT file + ".types"
+   * @param threads    number of threads used to build the index, 0 to use all hardware threads
+   * @return True if the index was built, False if an existing index was loaded
+   */
+  bool loadTypeIndex(std::vector<std::string> predicates = {"http://www.w3.org/1999/02/22-rdf-syntax-ns#type"},
+                     std::string path = "", int threads = 0);
+
+  /*!
+   * Get the types of a batch of entities, using the type index if it is loaded
+   * @param ids global IDs of the entities
+   * @return a tuple (indptr, types) in CSR format, with the global IDs of the sorted types of each entity
+   */
+  csr_types typesOf(py::array_t<unsigned int> ids);
+
   /*!
    * Get the string associated to a given id in the dictionary
    * @param id
@@ -238,6 +708,21 @@ public:
        */
     unsigned int StringToGlobalId (string term, hdt::TripleComponentRole role);
 
+  /*!
+   * Convert a batch of HDT ids with the same role to global ids
+   * @param ids  HDT ids
+   * @param role Role of the ids in the dictionary
+   * @return the global IDs
+   */
+  py::array_t<unsigned int> toGlobalIDs(py::array_t<unsigned int> ids, hdt::TripleComponentRole role);
+
+  /*!
+   * Convert a batch of global ids back to HDT ids
+   * @param ids Global ids
+   * @return a tuple (HDT IDs, roles), where roles are the hdt::TripleComponentRole used to decode each ID
+   */
+  std::tuple<py::array_t<unsigned int>, py::array_t<uint8_t>> fromGlobalIDs(py::array_t<unsigned int> ids);
+
   void remove();
 
 };
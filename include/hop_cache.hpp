@@ -0,0 +1,172 @@
+/**
+ * hop_cache.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_HOP_CACHE_HPP
+#define PYHDT_HOP_CACHE_HPP
+
+#include <HDTEnums.hpp>
+#include <SingleTriple.hpp>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The filtered triples around a term, for one hop
+typedef std::shared_ptr<const std::vector<hdt::TripleID>> hop_neighbourhood;
+
+/*!
+ * Hop filters used to compute a neighbourhood
+ */
+struct HopFilters {
+  // sorted IDs of the predicates
+  std::vector<unsigned int> predicates;
+  std::string prefix;
+  bool includeLiterals;
+  size_t maxOutDegree;
+  size_t maxInDegree;
+  bool truncateHubs;
+
+  bool operator==(const HopFilters &other) const {
+    return predicates == other.predicates && prefix == other.prefix &&
+           includeLiterals == other.includeLiterals && maxOutDegree == other.maxOutDegree &&
+           maxInDegree == other.maxInDegree && truncateHubs == other.truncateHubs;
+  }
+};
+
+/*!
+ * Key of a neighbourhood in a HopCache: the term, its role, and the hop filters
+ * used to compute the neighbourhood, with their hash. Keys with the same hash
+ * but different filters are different keys.
+ */
+struct HopCacheKey {
+  size_t term;
+  hdt::TripleComponentRole role;
+  size_t config;
+  // NULL for the default filters
+  std::shared_ptr<const HopFilters> filters;
+
+  bool operator==(const HopCacheKey &other) const {
+    return term == other.term && role == other.role && config == other.config &&
+           (filters == other.filters || (filters && other.filters && *filters == *other.filters));
+  }
+};
+
+struct HopCacheKeyHasher {
+  size_t operator()(const HopCacheKey &key) const {
+    size_t seed = key.term;
+    seed ^= (size_t) key.role + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= key.config + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+  }
+};
+
+/*!
+ * HopCache is a least recently used cache of hop neighbourhoods, bounded by
+ * the memory used by the cached triples. It is shared between the copies of
+ * a HDTDocument, and can be used by several threads.
+ */
+class HopCache {
+private:
+  typedef std::pair<HopCacheKey, hop_neighbourhood> entry;
+  size_t capacity;
+  size_t used;
+  size_t hits;
+  size_t misses;
+  // entries, from the most recently used to the least recently used
+  std::list<entry> entries;
+  std::unordered_map<HopCacheKey, std::list<entry>::iterator, HopCacheKeyHasher> index;
+  std::mutex mutex;
+
+  inline size_t sizeOf(const hop_neighbourhood &triples) const {
+    return sizeof(entry) + 2 * sizeof(void *) + triples->capacity() * sizeof(hdt::TripleID);
+  }
+
+  void evict() {
+    while (used > capacity && !entries.empty()) {
+      used -= sizeOf(entries.back().second);
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+public:
+  HopCache(size_t _capacity) : capacity(_capacity), used(0), hits(0), misses(0) {}
+
+  /*!
+   * Get a neighbourhood, or NULL if it is not in the cache
+   * @param  key Term, role and hop configuration of the neighbourhood
+   * @return     Cached triples, shared with the cache
+   */
+  hop_neighbourhood get(const HopCacheKey &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+      misses++;
+      return hop_neighbourhood();
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    return found->second->second;
+  }
+
+  /*!
+   * Insert a neighbourhood, evicting the least recently used ones if needed
+   * @param key       Term, role and hop configuration of the neighbourhood
+   * @param triples   Triples of the neighbourhood
+   */
+  void put(const HopCacheKey &key, hop_neighbourhood triples) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index.find(key) != index.end() || sizeOf(triples) > capacity) {
+      return;
+    }
+    entries.push_front(entry(key, triples));
+    index[key] = entries.begin();
+    used += sizeOf(triples);
+    evict();
+  }
+
+  /*!
+   * Change the maximum memory used by the cache, in bytes
+   * @param _capacity Maximum memory used by the cached triples, in bytes
+   */
+  void resize(size_t _capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = _capacity;
+    evict();
+  }
+
+  /*!
+   * Remove all neighbourhoods, and reset the counters
+   */
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    used = 0;
+    hits = 0;
+    misses = 0;
+  }
+
+  /*!
+   * Get the counters of the cache: hits, misses, number of entries, bytes used and capacity
+   * @return Counters, by name
+   */
+  std::map<std::string, size_t> getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, size_t> stats;
+    stats["hits"] = hits;
+    stats["misses"] = misses;
+    stats["entries"] = entries.size();
+    stats["bytes"] = used;
+    stats["capacity"] = capacity;
+    return stats;
+  }
+};
+
+#endif /* PYHDT_HOP_CACHE_HPP */
@@ -0,0 +1,70 @@
+/**
+ * hop_results.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_HOP_RESULTS_HPP
+#define PYHDT_HOP_RESULTS_HPP
+
+#include "array_utils.hpp"
+#include <pybind11/pybind11.h>
+#include <tuple>
+#include <vector>
+
+namespace py = pybind11;
+
+// A page of edges: a tuple (predicates, rows, cols), with one entry per edge
+typedef std::tuple<py::array_t<unsigned int>, py::array_t<unsigned int>, py::array_t<unsigned int>> hop_page;
+
+/*!
+ * HopResults holds the edges reachable from a set of terms, deduplicated and
+ * sorted by predicate, subject and object, so they can be read page by page.
+ * Pages are slices of the sorted edges, so they are stable and disjoint, and
+ * reading a page does not depend on the pages read before it.
+ */
+class HopResults {
+private:
+  py::array_t<unsigned int> entities;
+  std::vector<unsigned int> predicates;
+  std::vector<unsigned int> rows;
+  std::vector<unsigned int> cols;
+
+public:
+  /*!
+   * Constructor
+   * @param mappingLocalToGlobalID Global ID of each local ID
+   * @param _predicates            Predicate of each edge
+   * @param _rows                  Local ID of the subject of each edge
+   * @param _cols                  Local ID of the object of each edge
+   */
+  HopResults(std::vector<unsigned int> &&mappingLocalToGlobalID, std::vector<unsigned int> &&_predicates,
+             std::vector<unsigned int> &&_rows, std::vector<unsigned int> &&_cols);
+
+  /*!
+   * Get the global IDs of the entities, indexed by local ID
+   * @return Array of global IDs
+   */
+  py::array_t<unsigned int> getEntities();
+
+  /*!
+   * Get the number of edges
+   * @return Number of edges
+   */
+  size_t size();
+
+  /*!
+   * Get a page of edges
+   * @param  limit  Maximum number of edges
+   * @param  offset Number of edges to skip
+   * @return        Tuple (predicates, rows, cols) of the edges of the page
+   */
+  hop_page page(size_t limit, size_t offset);
+
+  /*!
+   * Get a representation of the results
+   * @return Representation of the results
+   */
+  std::string python_repr();
+};
+
+#endif /* PYHDT_HOP_RESULTS_HPP */
@@ -8,7 +8,13 @@
 
 #include "pyhdt_types.hpp"
 #include "QueryProcessor.hpp"
+#include "global_id_mapping.hpp"
+#include "join_operators.hpp"
+#include "term_filter.hpp"
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 /*!
  * JoinIterator iterates over solution bindings of a join
@@ -17,14 +23,49 @@
 class JoinIterator {
 private:
   hdt::VarBindingString *iterator;
+  BindingOperator *pipeline;
+  std::vector<std::string> varNames;
+  std::vector<hdt::TripleComponentRole> varRoles;
+  hdt::Dictionary *dictionary;
+  GlobalIDMapping mapping;
+  // lock of the dictionary and of the QueryProcessor, shared with the HDTDocument
+  std::shared_ptr<std::mutex> decodeMutex;
+  binding_row row;
   bool hasNextSolution = true;
+  // limit, offset and filters, when the join is evaluated by the QueryProcessor
+  size_t limit;
+  size_t offset;
+  size_t nbProduced;
+  std::vector<TermFilter> filters;
+
+  bool findNextSolution();
 
 public:
   /*!
    * Constructor
-   * @param iterator [description]
+   * @param iterator     [description]
+   * @param _decodeMutex Lock held while the QueryProcessor evaluates the join
+   * @param limit        Maximum number of solutions to produce, 0 for no limit
+   * @param offset       Number of solutions to skip
+   * @param filters      Filters on the join variables, checked on RDF terms
+   */
+  JoinIterator(hdt::VarBindingString *_it, std::shared_ptr<std::mutex> _decodeMutex,
+               size_t _limit = 0, size_t _offset = 0,
+               std::vector<TermFilter> _filters = std::vector<TermFilter>());
+
+  /*!
+   * Constructor, for a join evaluated by a pipeline of BindingOperators
+   * @param _pipeline Root of the pipeline, owned by the iterator
+   * @param _varNames Names of the join variables, ordered by slot
+   * @param _varRoles Role used to decode the value of each variable
+   * @param _dict     Dictionary used to decode the solution bindings
+   * @param _mapping  Mapping used to convert the global IDs of the solution bindings
+   * @param _decodeMutex Lock held while decoding the solution bindings
    */
-  JoinIterator(hdt::VarBindingString *_it);
+  JoinIterator(BindingOperator *_pipeline, std::vector<std::string> _varNames,
+               std::vector<hdt::TripleComponentRole> _varRoles,
+               hdt::Dictionary *_dict, GlobalIDMapping _mapping,
+               std::shared_ptr<std::mutex> _decodeMutex);
 
   /*!
    * Destructor
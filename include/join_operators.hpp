@@ -0,0 +1,446 @@
+/**
+ * join_operators.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_JOIN_OPERATORS_HPP
+#define PYHDT_JOIN_OPERATORS_HPP
+
+#include "global_id_mapping.hpp"
+#include "term_filter.hpp"
+#include <HDTEnums.hpp>
+#include <Iterator.hpp>
+#include <SingleTriple.hpp>
+#include <Triples.hpp>
+#include "thread_utils.hpp"
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Default memory budget of a hash join, in bytes
+#define HASH_JOIN_DEFAULT_MEMORY_BUDGET (256 * 1024 * 1024)
+
+// Approximate memory overhead of an entry in a hash table, in bytes
+#define HASH_ENTRY_OVERHEAD 32
+
+// A set of solution bindings, as global IDs.
+// Each variable of the join has a fixed slot, and 0 stands for "unbound".
+typedef std::vector<size_t> binding_row;
+
+/*!
+ * A triple pattern made of HDT ids, where each position is either a constant
+ * (vars[i] == -1) or a variable (vars[i] is the slot of the variable in a binding_row).
+ * Filters are checked on the variables bound by the pattern.
+ */
+struct PatternID {
+  hdt::TripleID ids;
+  int vars[3];
+  std::vector<TermFilter> filters;
+};
+
+/*!
+ * Bind a matching triple to the variables of a triple pattern.
+ * Returns False if the triple is not compatible with the bindings already present
+ * in row, or does not pass the filters of the pattern.
+ * @param  pattern Triple pattern which matched the triple
+ * @param  triple  Matching triple, made of HDT ids
+ * @param  mapping Mapping used to convert the HDT ids into global IDs
+ * @param  row     Solution bindings, updated with the variables of the pattern
+ * @return         True if the triple was bound
+ */
+bool bindTriple(const PatternID &pattern, const hdt::TripleID &triple,
+                const GlobalIDMapping &mapping, binding_row &row);
+
+/*!
+ * Substitute the variables of a triple pattern using a set of solution bindings.
+ * Returns False if a binding cannot appear in the pattern, i.e., no triple can match.
+ * @param  pattern Triple pattern to substitute
+ * @param  row     Solution bindings
+ * @param  mapping Mapping used to convert the bound global IDs into HDT ids
+ * @param  result  Triple pattern made of HDT ids, where 0 is a variable
+ * @return         True if result can match some triples
+ */
+bool bindPattern(const PatternID &pattern, const binding_row &row,
+                 const GlobalIDMapping &mapping, hdt::TripleID &result);
+
+/*!
+ * Hash the join key of a set of solution bindings
+ * @param  row     Solution bindings
+ * @param  keyVars Slots of the variables of the join key
+ * @return         The hash of the values of the key variables
+ */
+size_t hashKey(const size_t *row, const std::vector<int> &keyVars);
+
+/*!
+ * BindingOperator is a physical operator of a join pipeline, which produces
+ * solution bindings as rows of global IDs
+ */
+class BindingOperator {
+public:
+  virtual ~BindingOperator() {}
+
+  /*!
+   * Produce the next set of solution bindings into row.
+   * Return False if the operator has no more solutions.
+   * @param  row Output solution bindings, with one slot per join variable
+   * @return     True if a set of solution bindings was produced
+   */
+  virtual bool next(binding_row &row) = 0;
+
+  /*!
+   * Reset the operator into its initial state
+   */
+  virtual void reset() = 0;
+
+  /*!
+   * Get the estimated number of solutions produced by the operator
+   * @return The estimated number of solutions
+   */
+  virtual size_t estimatedCardinality() = 0;
+};
+
+/*!
+ * PatternScan evaluates a single triple pattern against the HDT triples
+ */
+class PatternScan : public BindingOperator {
+private:
+  hdt::Triples *triples;
+  PatternID pattern;
+  GlobalIDMapping mapping;
+  size_t nbVars;
+  hdt::IteratorTripleID *iterator;
+  size_t cardinality;
+  // optional range of positions to read
+  size_t start;
+  size_t count;
+  size_t nbRead;
+
+public:
+  PatternScan(hdt::Triples *_triples, PatternID _pattern,
+              GlobalIDMapping _mapping, size_t _nbVars);
+  ~PatternScan();
+
+  /*!
+   * Only read the count triples found after position start.
+   * Requires an iterator which can go to a position.
+   * @param _start Position of the first triple to read
+   * @param _count Number of triples to read
+   */
+  void restrictPositions(size_t _start, size_t _count);
+
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+/*!
+ * SharedScan hands out chunks of the solutions of a PatternScan to the workers
+ * of a ParallelJoin, when the iterator of the driving pattern cannot jump to a
+ * position: the pattern is read once, whatever the number of workers.
+ * A chunk never ends between two solutions binding the split variable to the
+ * same value, so each value is processed by a single worker.
+ */
+class SharedScan {
+private:
+  PatternScan *scan;
+  int splitVar;
+  size_t nbVars;
+  std::mutex mutex;
+  // first solution of the next chunk, read while closing the previous one
+  binding_row pending;
+  bool hasPending;
+
+public:
+  /*!
+   * Constructor
+   * @param _scan     Scan of the driving pattern, owned by the SharedScan
+   * @param _splitVar Slot of the variable whose values are not split between
+   *                  chunks, or -1 to split chunks anywhere
+   * @param _nbVars   Number of variables of the join
+   */
+  SharedScan(PatternScan *_scan, int _splitVar, size_t _nbVars);
+  ~SharedScan();
+
+  /*!
+   * Read the next chunk of solutions.
+   * Returns False if the scan has ended.
+   * @param  chunk Output solutions, with nbVars values per solution
+   * @return       True if the chunk holds at least one solution
+   */
+  bool nextChunk(std::vector<size_t> &chunk);
+
+  /*!
+   * Restart the scan from its first solution
+   */
+  void reset();
+
+  /*!
+   * Get the estimated number of solutions of the whole scan
+   * @return The estimated number of solutions
+   */
+  size_t estimatedCardinality();
+};
+
+/*!
+ * ChunkScan is the driving operator of a worker of a ParallelJoin, which
+ * reads chunks of solutions from a SharedScan
+ */
+class ChunkScan : public BindingOperator {
+private:
+  std::shared_ptr<SharedScan> shared;
+  size_t nbVars;
+  std::vector<size_t> chunk;
+  size_t chunkPos;
+
+public:
+  /*!
+   * Constructor
+   * @param _shared Scan shared by the workers
+   * @param _nbVars Number of variables of the join
+   */
+  ChunkScan(std::shared_ptr<SharedScan> _shared, size_t _nbVars);
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+/*!
+ * BindJoin is an index nested loop join: for each set of bindings read from
+ * the left operator, it searches for the matching triples of the right pattern.
+ */
+class BindJoin : public BindingOperator {
+private:
+  BindingOperator *left;
+  hdt::Triples *triples;
+  PatternID right;
+  GlobalIDMapping mapping;
+  size_t rightCardinality;
+  binding_row current;
+  hdt::IteratorTripleID *iterator;
+
+public:
+  BindJoin(BindingOperator *_left, hdt::Triples *_triples, PatternID _right,
+           GlobalIDMapping _mapping, size_t _rightCardinality);
+  ~BindJoin();
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+/*!
+ * HashJoin joins two operators on their shared variables, using an in-memory
+ * hash table built over the "build" side and probed with the "probe" side.
+ * When the hash table exceeds the memory budget, both inputs are partitioned
+ * on disk by hash of the join key, and partitions are joined one at a time.
+ */
+class HashJoin : public BindingOperator {
+private:
+  BindingOperator *build;
+  BindingOperator *probe;
+  std::vector<int> keyVars;
+  size_t nbVars;
+  size_t memoryBudget;
+  bool built;
+  // in-memory hash table: hash of the join key -> offset of the row in buildRows
+  std::vector<size_t> buildRows;
+  std::unordered_multimap<size_t, size_t> table;
+  // partitions spilled on disk
+  bool spilled;
+  std::vector<FILE *> buildPartitions;
+  std::vector<FILE *> probePartitions;
+  size_t currentPartition;
+  // probing state
+  binding_row probeRow;
+  std::vector<size_t> matches;
+  size_t matchPos;
+
+  size_t keyHash(const binding_row &row);
+  size_t partitionOf(const binding_row &row);
+  size_t memoryUsage();
+  void insert(const binding_row &row);
+  void buildTable();
+  void spill();
+  void loadPartition(size_t partition);
+  bool nextProbeRow();
+  void closePartitions();
+
+public:
+  HashJoin(BindingOperator *_build, BindingOperator *_probe,
+           std::vector<int> _keyVars, size_t _nbVars, size_t _memoryBudget);
+  ~HashJoin();
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+/*!
+ * SharedHashTable is the hash table of a hash join shared by the workers of a
+ * ParallelJoin. It is built once, by the first worker which needs it, and then
+ * probed concurrently without locks. It is never partitioned on disk, so the
+ * planner only shares tables whose build input fits the memory budget.
+ */
+class SharedHashTable {
+private:
+  BindingOperator *build;
+  std::vector<int> keyVars;
+  size_t nbVars;
+  std::mutex mutex;
+  bool built;
+  // hash of the join key -> offset of the row in rows
+  std::vector<size_t> rows;
+  std::unordered_multimap<size_t, size_t> table;
+
+public:
+  /*!
+   * Constructor
+   * @param _build   Operator read into the hash table, owned by the table
+   * @param _keyVars Slots of the variables of the join key
+   * @param _nbVars  Number of variables of the join
+   */
+  SharedHashTable(BindingOperator *_build, std::vector<int> _keyVars, size_t _nbVars);
+  ~SharedHashTable();
+
+  /*!
+   * Read the build input into the hash table, unless another worker already did
+   */
+  void ensureBuilt();
+
+  /*!
+   * Find the rows of the hash table with the same join key as a set of bindings
+   * @param row     Solution bindings of the probe side
+   * @param matches Output offsets of the matching rows, cleared first
+   */
+  void findMatches(const binding_row &row, std::vector<size_t> &matches) const;
+
+  /*!
+   * Get a row of the hash table
+   * @param  offset Offset of the row, as found by findMatches
+   * @return        The nbVars values of the row
+   */
+  const size_t *getRow(size_t offset) const;
+
+  /*!
+   * Get the estimated number of rows of the build input
+   * @return The estimated number of rows
+   */
+  size_t estimatedCardinality();
+};
+
+/*!
+ * SharedHashJoin probes a SharedHashTable with the solutions of an operator
+ */
+class SharedHashJoin : public BindingOperator {
+private:
+  BindingOperator *probe;
+  std::shared_ptr<SharedHashTable> table;
+  size_t nbVars;
+  bool ready;
+  binding_row probeRow;
+  std::vector<size_t> matches;
+  size_t matchPos;
+
+public:
+  /*!
+   * Constructor
+   * @param _probe  Operator probing the hash table, owned by the join
+   * @param _table  Hash table shared with the other workers
+   * @param _nbVars Number of variables of the join
+   */
+  SharedHashJoin(BindingOperator *_probe, std::shared_ptr<SharedHashTable> _table, size_t _nbVars);
+  ~SharedHashJoin();
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+/*!
+ * StarJoin evaluates a star of triple patterns sharing the same subject variable,
+ * e.g., { ?s p1 ?o1 . ?s p2 o2 }. Candidate subjects are read from the most
+ * selective pattern, then all patterns are checked against the subject's
+ * adjacency list, read with a single scan of BitmapTriples.
+ */
+class StarJoin : public BindingOperator {
+private:
+  BindingOperator *driving;
+  hdt::Triples *triples;
+  std::vector<PatternID> patterns;
+  GlobalIDMapping mapping;
+  size_t nbVars;
+  int subjectVar;
+  size_t lastSubject;
+  // for each pattern, the matching objects of the current subject
+  std::vector<std::vector<size_t>> matches;
+  std::vector<size_t> positions;
+  bool hasSolutions;
+  binding_row current;
+
+  bool acceptsObject(const PatternID &pattern, size_t object);
+  bool readSubject(size_t subject);
+
+public:
+  StarJoin(BindingOperator *_driving, hdt::Triples *_triples,
+           std::vector<PatternID> _patterns, GlobalIDMapping _mapping,
+           size_t _nbVars);
+  ~StarJoin();
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+/*!
+ * SliceOperator skips the first offset solutions of an operator, and stops
+ * reading it after limit solutions (0 means no limit).
+ */
+class SliceOperator : public BindingOperator {
+private:
+  BindingOperator *child;
+  size_t limit;
+  size_t offset;
+  size_t nbProduced;
+  bool skipped;
+  bool done;
+
+public:
+  SliceOperator(BindingOperator *_child, size_t _limit, size_t _offset);
+  ~SliceOperator();
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+/*!
+ * ParallelJoin runs several copies of a pipeline in parallel, one per worker
+ * thread, where each copy reads a different slice of the driving triple pattern.
+ * Solutions are merged through a bounded queue, in no particular order.
+ */
+class ParallelJoin : public BindingOperator {
+private:
+  std::vector<BindingOperator *> pipelines;
+  size_t nbVars;
+  size_t cardinality;
+  size_t queueCapacity;
+  BoundedQueue<std::vector<size_t>> *queue;
+  std::vector<std::thread> workers;
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  std::vector<size_t> batch;
+  size_t batchPos;
+
+  void start();
+  void stop();
+  void runWorker(BindingOperator *pipeline);
+
+public:
+  ParallelJoin(std::vector<BindingOperator *> _pipelines, size_t _nbVars,
+               size_t _cardinality, size_t _queueCapacity);
+  ~ParallelJoin();
+  bool next(binding_row &row);
+  void reset();
+  size_t estimatedCardinality();
+};
+
+#endif /* PYHDT_JOIN_OPERATORS_HPP */
@@ -0,0 +1,119 @@
+/**
+ * join_planner.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_JOIN_PLANNER_HPP
+#define PYHDT_JOIN_PLANNER_HPP
+
+#include "HDT.hpp"
+#include "global_id_mapping.hpp"
+#include "join_operators.hpp"
+#include "pyhdt_types.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Hash joins are only considered when both inputs are at least this large:
+// below, index probes are cheap enough.
+#define HASH_JOIN_MIN_CARDINALITY 4096
+
+// Joins are only evaluated in parallel when the driving pattern is at least this large
+#define PARALLEL_MIN_CARDINALITY 1024
+
+/*!
+ * JoinPlanner builds a pipeline of BindingOperators to evaluate a conjunction of
+ * triple patterns. Patterns are ordered by estimated cardinality, and each join
+ * is evaluated either as an index nested loop (BindJoin) or as a HashJoin,
+ * depending on which one is cheaper. Stars of patterns sharing the same subject
+ * are evaluated using a StarJoin. With several threads, the pipeline is
+ * replicated over slices of the driving pattern (ParallelJoin).
+ * Filters on a variable are checked by the first pattern binding it.
+ */
+class JoinPlanner {
+private:
+  hdt::HDT *hdt;
+  GlobalIDMapping mapping;
+  std::vector<PatternID> patterns;
+  std::vector<size_t> cardinalities;
+  std::vector<std::string> varNames;
+  std::vector<hdt::TripleComponentRole> varRoles;
+  std::vector<TermFilter> filters;
+  bool supported;
+  size_t hashJoinMinCardinality;
+  size_t parallelMinCardinality;
+  // join order, and for each pattern, if it is joined using a hash join
+  std::vector<size_t> order;
+  std::vector<bool> useHashJoin;
+
+  int addVariable(std::string name, hdt::TripleComponentRole role);
+  void orderPatterns(size_t nbWorkers, size_t memoryBudget, bool allowHashJoin);
+  void assignFilters();
+  BindingOperator *buildPipeline(BindingOperator *driving, size_t memoryBudget,
+                                 std::vector<std::shared_ptr<SharedHashTable>> *sharedTables);
+  BindingOperator *buildParallel(size_t memoryBudget, size_t nbWorkers, bool star);
+  bool isStar();
+  size_t alignPosition(PatternID &pattern, int var, size_t position);
+
+public:
+  /*!
+   * Constructor
+   * @param _hdt      HDT document queried
+   * @param _patterns Triple patterns of the join, where variables start with '?'
+   * @param _filters  Filters on the join variables
+   */
+  JoinPlanner(hdt::HDT *_hdt, std::vector<triple> &_patterns,
+              std::vector<filter_expr> _filters = std::vector<filter_expr>());
+
+  /*!
+   * Build the pipeline of operators used to evaluate the join.
+   * Returns NULL if the join is better evaluated by the HDT QueryProcessor.
+   * @param  memoryBudget Memory budget of each hash join, in bytes. With several
+   *                      threads, hash tables are shared by the workers and kept
+   *                      in memory, and this is the budget of all of them.
+   * @param  threads      Number of worker threads, 0 to use all hardware threads
+   * @param  limit        Maximum number of solutions to produce, 0 for no limit
+   * @param  offset       Number of solutions to skip
+   * @return              The root of the pipeline, owned by the caller, or NULL
+   */
+  BindingOperator *plan(size_t memoryBudget, int threads, size_t limit = 0,
+                        size_t offset = 0);
+
+  /*!
+   * Set the minimum cardinality of both inputs of a hash join
+   * @param cardinality Minimum estimated number of solutions of each input
+   */
+  void setHashJoinMinCardinality(size_t cardinality);
+
+  /*!
+   * Set the minimum cardinality of the driving pattern of a parallel join
+   * @param cardinality Minimum estimated number of triples of the driving pattern
+   */
+  void setParallelMinCardinality(size_t cardinality);
+
+  /*!
+   * Get the names of the join variables, ordered by slot in the solution bindings
+   * @return The names of the variables, with their leading '?'
+   */
+  std::vector<std::string> getVarNames();
+
+  /*!
+   * Get the role used to decode the value of each join variable
+   * @return For each variable, the role of its first occurrence in the patterns
+   */
+  std::vector<hdt::TripleComponentRole> getVarRoles();
+
+  /*!
+   * Get the mapping used to convert IDs in the solution bindings
+   * @return The mapping of the HDT document
+   */
+  GlobalIDMapping getMapping();
+
+  /*!
+   * Get the filters on the join variables
+   * @return Compiled filters, whose slots are the indexes of the variables
+   */
+  std::vector<TermFilter> getFilters();
+};
+
+#endif /* PYHDT_JOIN_PLANNER_HPP */
@@ -0,0 +1,67 @@
+/**
+ * mapped_file.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_MAPPED_FILE_HPP
+#define PYHDT_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ * MappedFile is a read-only memory mapping of a file. As the mapping is shared,
+ * processes mapping the same file, or forked after mapping it, share its pages
+ * through the page cache. Within a process, MappedFile::open returns a single
+ * mapping per file, which is released when it is no longer used.
+ */
+class MappedFile {
+private:
+  std::string path;
+  void *data;
+  size_t size;
+  // identity of the mapped file, to detect when it is replaced
+  unsigned long long device;
+  unsigned long long inode;
+
+  // not copyable, as it owns the memory mapping
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+public:
+  /*!
+   * Map a file in memory. Throws a runtime_error if the file cannot be mapped.
+   * @param _path Path of the file
+   */
+  MappedFile(std::string _path);
+
+  /*!
+   * Destructor
+   */
+  ~MappedFile();
+
+  /*!
+   * Get the mapping of a file, reusing the mapping of this process if the
+   * file is already mapped and was not replaced since.
+   * @param  path Path of the file
+   * @return      Mapping of the file
+   */
+  static std::shared_ptr<MappedFile> open(std::string path);
+
+  /*!
+   * Write a file from a list of (buffer, size) chunks. The file is written
+   * under a temporary name, then renamed, so that readers never map a partial file.
+   * @param path   Path of the file
+   * @param chunks Buffers written one after the other, with their size in bytes
+   */
+  static void write(std::string path, const std::vector<std::pair<const void *, size_t>> &chunks);
+
+  std::string getPath() const;
+  const char *getData() const;
+  size_t getSize() const;
+};
+
+#endif /* PYHDT_MAPPED_FILE_HPP */
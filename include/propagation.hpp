@@ -0,0 +1,79 @@
+/**
+ * propagation.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_PROPAGATION_HPP
+#define PYHDT_PROPAGATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/*!
+ * PropagationGraph is an undirected weighted graph, stored in CSR format, over
+ * which activations are propagated by sparse matrix-vector products.
+ * It is built from the per-predicate adjacency matrices of a hop subgraph,
+ * where each edge is weighted by the weight of its predicate.
+ */
+class PropagationGraph {
+private:
+  size_t nbNodes;
+  std::vector<uint64_t> indptr;
+  std::vector<unsigned int> indices;
+  std::vector<float> weights;
+  // sum of the weights of the edges of each node
+  std::vector<double> strengths;
+
+public:
+  /*!
+   * Constructor
+   * @param _nbNodes         Number of nodes of the hop subgraph
+   * @param predicates       Predicate of each adjacency matrix
+   * @param rows             Rows of each adjacency matrix
+   * @param cols             Columns of each adjacency matrix
+   * @param predicateWeights Weight of the edges of each predicate
+   * @param defaultWeight    Weight of the edges of other predicates
+   */
+  PropagationGraph(size_t _nbNodes, std::vector<unsigned int> &predicates,
+                   std::vector<std::vector<unsigned int>> &rows,
+                   std::vector<std::vector<unsigned int>> &cols,
+                   std::map<unsigned int, double> &predicateWeights, double defaultWeight);
+
+  /*!
+   * Compute y = A x, where A is the weighted adjacency matrix, normalized by
+   * the strength of each source node if normalized is True
+   * @param x          Input vector, of size nbNodes
+   * @param y          Output vector, of size nbNodes
+   * @param normalized If True, normalize by the strength of each source node
+   * @param nbThreads  Number of threads
+   */
+  void multiply(const std::vector<double> &x, std::vector<double> &y, bool normalized,
+                size_t nbThreads) const;
+
+  /*!
+   * Spreading activation: activations are summed over the weighted edges, then
+   * scaled so that the largest activation is 1, at each iteration
+   * @param  seeds      Initial activation of each node
+   * @param  iterations Number of iterations
+   * @param  nbThreads  Number of threads
+   * @return            Activation of each node
+   */
+  std::vector<double> spread(std::vector<double> seeds, size_t iterations, size_t nbThreads) const;
+
+  /*!
+   * Personalized PageRank, computed by power iteration. The random surfer
+   * teleports back to the seeds with probability alpha, and from nodes
+   * without any edge.
+   * @param  seeds      Teleport distribution, summing to 1
+   * @param  iterations Number of power iterations
+   * @param  alpha      Teleport probability
+   * @param  nbThreads  Number of threads
+   * @return            PageRank score of each node
+   */
+  std::vector<double> personalizedPageRank(const std::vector<double> &seeds, size_t iterations,
+                                           double alpha, size_t nbThreads) const;
+};
+
+#endif /* PYHDT_PROPAGATION_HPP */
@@ -10,6 +10,7 @@
 #include <string>
 #include <tuple>
 #include <set>
+#include <vector>
 
 // A RDF Triple. RDF terms are represented as simple strings by HDT.
 typedef std::tuple<std::string, std::string, std::string> triple;
@@ -31,4 +32,8 @@ typedef std::tuple<std::string, std::string> single_binding;
 
 typedef std::set<single_binding> *solution_bindings;
 
+// A filter over RDF terms: (target, operator) or (target, operator, argument),
+// e.g., ("object", "literal") or ("?x", "prefix", "http://example.org/")
+typedef std::vector<std::string> filter_expr;
+
 #endif /* PYHDT_TYPES_HPP */
@@ -0,0 +1,82 @@
+/**
+ * term_filter.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_TERM_FILTER_HPP
+#define PYHDT_TERM_FILTER_HPP
+
+#include "pyhdt_types.hpp"
+#include <Dictionary.hpp>
+#include <HDTEnums.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A range of IDs [first, second)
+typedef std::pair<size_t, size_t> id_range;
+
+/*!
+ * TermFilter is a filter over the RDF terms bound to a triple position or to
+ * a join variable. Supported operators are:
+ *  - "iri": the term is an IRI.
+ *  - "literal": the term is a literal.
+ *  - "prefix": the term starts with the given prefix, e.g., a namespace.
+ *  - "lang": the term is a literal with the given language tag.
+ * As each section of the HDT dictionary is sorted, these filters are compiled
+ * into ranges of IDs, so they are evaluated using integer comparisons, without
+ * decoding terms. Language tags are not sorted, so they are compiled by decoding
+ * each literal once, when the filter is built.
+ */
+class TermFilter {
+private:
+  hdt::Dictionary *dictionary;
+  std::string target;
+  std::string op;
+  std::string arg;
+  int slot;
+  // accepted IDs, for each role, sorted and disjoint
+  std::vector<id_range> ranges[3];
+
+  void compileLiterals(std::vector<id_range> &accepted, hdt::TripleComponentRole role,
+                       id_range literals);
+  void compileRanges(hdt::TripleComponentRole role, size_t first, size_t last);
+
+public:
+  /*!
+   * Constructor
+   * @param _dict Dictionary used to compile the filter
+   * @param expr  Filter expression, as (target, operator) or (target, operator, argument)
+   * @param _slot Triple position or join variable filtered
+   */
+  TermFilter(hdt::Dictionary *_dict, filter_expr expr, int _slot);
+
+  /*!
+   * Get the triple position or the variable targeted by the filter
+   * @return Name of the triple position, or of the variable
+   */
+  std::string getTarget() const;
+
+  /*!
+   * Get the slot (triple position or join variable) filtered
+   * @return Index of the triple position, or of the variable
+   */
+  int getSlot() const;
+
+  /*!
+   * Test if a term passes the filter, using its ID. The dictionary is not used.
+   * @param  id   HDT ID of the term
+   * @param  role Role of the term, which selects the dictionary section of the ID
+   * @return      True if the term passes the filter
+   */
+  bool accepts(size_t id, hdt::TripleComponentRole role) const;
+
+  /*!
+   * Test if a term passes the filter, using its string representation
+   * @param  term RDF term
+   * @return      True if the term passes the filter
+   */
+  bool acceptsTerm(const std::string &term) const;
+};
+
+#endif /* PYHDT_TERM_FILTER_HPP */
@@ -0,0 +1,245 @@
+/**
+ * thread_utils.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_THREAD_UTILS_HPP
+#define PYHDT_THREAD_UTILS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * Get the number of threads to use: 0 means "as many as hardware threads"
+ * @param  threads Number of threads requested
+ * @return         The number of threads to use, at least 1
+ */
+inline size_t resolveThreads(int threads) {
+  if (threads > 0) {
+    return threads;
+  }
+  size_t hardware = std::thread::hardware_concurrency();
+  return (hardware > 0) ? hardware : 1;
+}
+
+/*!
+ * Call body(begin, end) over contiguous slices of [0, n), using up to
+ * nbThreads threads. Exceptions raised by the body are rethrown once all
+ * threads are done.
+ * @param n         Number of items
+ * @param nbThreads Maximum number of threads
+ * @param body      Function called with the bounds [begin, end) of each slice
+ */
+template <typename F> void parallelFor(size_t n, size_t nbThreads, F body) {
+  nbThreads = std::max((size_t) 1, std::min(nbThreads, n));
+  if (nbThreads == 1) {
+    body(0, n);
+    return;
+  }
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(nbThreads);
+  for (size_t i = 0; i < nbThreads; i++) {
+    workers.push_back(std::thread([&body, &errors, i, n, nbThreads]() {
+      try {
+        body((n * i) / nbThreads, (n * (i + 1)) / nbThreads);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }));
+  }
+  for (size_t i = 0; i < nbThreads; i++) {
+    workers[i].join();
+  }
+  for (size_t i = 0; i < nbThreads; i++) {
+    if (errors[i]) {
+      std::rethrow_exception(errors[i]);
+    }
+  }
+}
+
+/*!
+ * BoundedQueue is a blocking FIFO queue with a maximum capacity, shared
+ * between several producers and a single consumer.
+ */
+template <typename T> class BoundedQueue {
+private:
+  std::deque<T> items;
+  size_t capacity;
+  size_t nbProducers;
+  bool cancelled;
+  std::mutex mutex;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+
+public:
+  BoundedQueue(size_t _capacity, size_t _nbProducers)
+      : capacity(_capacity), nbProducers(_nbProducers), cancelled(false) {}
+
+  /*!
+   * Push an item, waiting while the queue is full.
+   * Returns False if the queue has been cancelled by the consumer.
+   * @param  item Item to push, moved into the queue
+   * @return      True if the item was pushed
+   */
+  bool push(T &item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this] { return cancelled || items.size() < capacity; });
+    if (cancelled) {
+      return false;
+    }
+    items.push_back(std::move(item));
+    notEmpty.notify_one();
+    return true;
+  }
+
+  /*!
+   * Pop an item, waiting while the queue is empty.
+   * Returns False once the queue is empty and all producers are done.
+   * @param  item Output item
+   * @return      True if an item was popped
+   */
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this] { return cancelled || !items.empty() || nbProducers == 0; });
+    if (cancelled || items.empty()) {
+      return false;
+    }
+    item = std::move(items.front());
+    items.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+  /*!
+   * Signal that a producer will not push any more items
+   */
+  void producerDone() {
+    std::lock_guard<std::mutex> lock(mutex);
+    nbProducers--;
+    notEmpty.notify_all();
+  }
+
+  /*!
+   * Wake up all producers and consumers, and make them stop
+   */
+  void cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+    notFull.notify_all();
+    notEmpty.notify_all();
+  }
+};
+
+/*!
+ * RingBuffer is a lock-free FIFO queue with a fixed capacity, shared between
+ * exactly one producer and one consumer. Both sides wait by spinning, then
+ * sleeping for short periods, so it suits producers which are rarely idle.
+ */
+template <typename T> class RingBuffer {
+private:
+  // one slot is always left empty, to tell a full buffer from an empty one
+  std::vector<T> slots;
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+  std::atomic<bool> closed;
+  std::atomic<bool> cancelled;
+
+  /*!
+   * Wait a little, after a failed attempt to push or pop an item
+   * @param attempts Number of failed attempts so far
+   */
+  inline void backoff(size_t attempts) {
+    if (attempts < 64) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+public:
+  RingBuffer(size_t capacity)
+      : slots(capacity + 1), head(0), tail(0), closed(false), cancelled(false) {}
+
+  /*!
+   * Push an item if the buffer is not full. Only called by the producer.
+   * @param  item Item to push, moved into the buffer on success
+   * @return      True if the item has been pushed
+   */
+  bool tryPush(T &item) {
+    size_t current = tail.load(std::memory_order_relaxed);
+    size_t next = (current + 1) % slots.size();
+    if (next == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots[current] = std::move(item);
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /*!
+   * Pop an item if the buffer is not empty. Only called by the consumer.
+   * @param  item Output: the popped item
+   * @return      True if an item has been popped
+   */
+  bool tryPop(T &item) {
+    size_t current = head.load(std::memory_order_relaxed);
+    if (current == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = std::move(slots[current]);
+    head.store((current + 1) % slots.size(), std::memory_order_release);
+    return true;
+  }
+
+  /*!
+   * Push an item, waiting while the buffer is full.
+   * Returns False if the buffer has been cancelled by the consumer.
+   * @param  item Item to push, moved into the buffer
+   * @return      True if the item has been pushed
+   */
+  bool push(T &item) {
+    for (size_t attempts = 0; !tryPush(item); attempts++) {
+      if (cancelled.load(std::memory_order_acquire)) {
+        return false;
+      }
+      backoff(attempts);
+    }
+    return true;
+  }
+
+  /*!
+   * Pop an item, waiting while the buffer is empty.
+   * Returns False once the buffer is empty and closed by the producer.
+   * @param  item Output: the popped item
+   * @return      True if an item has been popped
+   */
+  bool pop(T &item) {
+    for (size_t attempts = 0; !tryPop(item); attempts++) {
+      if (closed.load(std::memory_order_acquire)) {
+        // items pushed just before closing the buffer
+        return tryPop(item);
+      }
+      backoff(attempts);
+    }
+    return true;
+  }
+
+  /*!
+   * Signal that the producer will not push any more items
+   */
+  void close() { closed.store(true, std::memory_order_release); }
+
+  /*!
+   * Make the producer stop pushing items
+   */
+  void cancel() { cancelled.store(true, std::memory_order_release); }
+};
+
+#endif /* PYHDT_THREAD_UTILS_HPP */
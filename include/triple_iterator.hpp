@@ -7,25 +7,68 @@
 #define TRIPLE_ITERATOR_HPP
 
 #include "tripleid_iterator.hpp"
+#include "array_utils.hpp"
 #include "pyhdt_types.hpp"
+#include "thread_utils.hpp"
 #include "Dictionary.hpp"
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 /*!
  * TripleIterator iterates over RDF triples of an HDT document which match a
- * triple pattern + limit + offset \author Thomas Minier
+ * triple pattern + limit + offset.
+ * With prefetching, a background thread scans and decodes the triples ahead
+ * of the consumer, into a ring buffer. In raw mode, RDF terms are returned
+ * to Python as bytes, without UTF-8 decoding. \author Thomas Minier
  */
 class TripleIterator {
 private:
   TripleIDIterator *iterator;
   hdt::Dictionary *dictionary;
+  // lock of the dictionary, shared with the HDTDocument
+  std::shared_ptr<std::mutex> decodeMutex;
+  // prefetching state
+  RingBuffer<triple> *buffer;
+  std::thread producer;
+  std::exception_ptr error;
+  size_hint hint;
+  triple bufferedTriple;
+  bool hasBufferedTriple;
+  bool ended;
+  unsigned int resultsRead;
+  bool raw;
+
+  void runProducer();
+  bool fetchNext();
+  triple decode(const triple_id &t);
+  py::object toPython(const triple &t);
 
 public:
   /*!
    * Constructor
-   * @param iterator [description]
+   * @param iterator     [description]
+   * @param _dict        [description]
+   * @param _decodeMutex Lock held while decoding triples
    */
-  TripleIterator(TripleIDIterator *_it, hdt::Dictionary *_dict);
+  TripleIterator(TripleIDIterator *_it, hdt::Dictionary *_dict,
+                 std::shared_ptr<std::mutex> _decodeMutex);
+
+  /*!
+   * Constructor, for an iterator which may prefetch triples in a background
+   * thread, or return raw RDF terms
+   * @param iterator     [description]
+   * @param _dict        [description]
+   * @param _decodeMutex Lock held while decoding triples
+   * @param prefetch     Maximum number of decoded triples waiting to be consumed, 0 to disable prefetching
+   * @param _raw         If True, RDF terms are returned to Python as bytes
+   */
+  TripleIterator(TripleIDIterator *_it, hdt::Dictionary *_dict,
+                 std::shared_ptr<std::mutex> _decodeMutex, size_t prefetch,
+                 bool _raw = false);
 
   /*!
    * Destructor
@@ -103,12 +146,41 @@ public:
    */
   triple next();
 
+  /**
+   * Get up to n items from the iterator, or nothing if the iterator has ended
+   * @param  n Maximum number of items
+   * @return   Items read, fewer than n at the end of the iterator
+   */
+  std::vector<triple> nextBatch(size_t n);
+
   /**
    * Get the next item in the iterator, or raise py::StopIteration if the
    * iterator has ended, but without advancing the iterator.
    * @return [description]
    */
   triple peek();
+
+  /*!
+   * Implementation for Python function "__next__", which returns str or bytes
+   * depending on the raw mode
+   * @return Next triple, as a tuple of str, or of bytes in raw mode
+   */
+  py::object python_next();
+
+  /*!
+   * Implementation for Python function "peek"
+   * @return Next triple, as a tuple of str, or of bytes in raw mode
+   */
+  py::object python_peek();
+
+  /*!
+   * Implementation for Python function "next_batch". In raw mode, a batch is
+   * a tuple (buffer, offsets), where the i-th RDF term is buffer[offsets[i]:offsets[i + 1]]
+   * and terms are ordered subject, predicate, object for each triple.
+   * @param  n Maximum number of triples
+   * @return   List of triples, or a tuple (buffer, offsets) in raw mode
+   */
+  py::object python_nextBatch(size_t n);
 };
 
 #endif /* TRIPLE_ITERATOR_HPP */
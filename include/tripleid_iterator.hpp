@@ -6,13 +6,17 @@
 #ifndef TRIPLEID_ITERATOR_HPP
 #define TRIPLEID_ITERATOR_HPP
 
+#include "array_utils.hpp"
 #include "pyhdt_types.hpp"
+#include "term_filter.hpp"
 #include <Iterator.hpp>
+#include <SingleTriple.hpp>
 #include <string>
+#include <vector>
 
 /*!
  * TripleIDIterator iterates over IDs of RDF triples of an HDT document which
- * match a triple pattern + limit + offset \author Thomas Minier
+ * match a triple pattern + filters + limit + offset \author Thomas Minier
  */
 class TripleIDIterator {
 private:
@@ -22,10 +26,13 @@ private:
   unsigned int limit;
   unsigned int offset;
   hdt::IteratorTripleID *iterator;
+  std::vector<TermFilter> filters;
   triple_id _bufferedTriple;
   bool hasBufferedTriple = false;
   unsigned int resultsRead = 0;
 
+  bool acceptsTriple(const hdt::TripleID &triple);
+
 public:
   /*!
    * Constructor
@@ -35,6 +42,15 @@ public:
                    std::string _pred, std::string _obj, unsigned int _limit,
                    unsigned int _offset);
 
+  /*!
+   * Constructor, for an iterator which only returns the triples passing a set of filters.
+   * As the offset counts filtered triples, it is applied by the iterator itself.
+   * @param iterator HDT iterator over the triples matching the pattern, filtered by _filters
+   */
+  TripleIDIterator(hdt::IteratorTripleID *_it, std::string _subj,
+                   std::string _pred, std::string _obj, unsigned int _limit,
+                   unsigned int _offset, std::vector<TermFilter> _filters);
+
   /*!
    * Destructor
    */
@@ -93,7 +109,7 @@ public:
 
   /*!
    * Get the estimated cardinality of the pattern currently evaluated.
-   * Offset & limit are not taken into account.
+   * Offset, limit & filters are not taken into account.
    * @return [description]
    */
   size_hint sizeHint();
@@ -111,6 +127,13 @@ public:
    */
   triple_id next();
 
+  /**
+   * Get up to n items from the iterator, or nothing if the iterator has ended
+   * @param  n Maximum number of items
+   * @return   Items read, fewer than n at the end of the iterator
+   */
+  py::array_t<unsigned int> nextBatch(size_t n);
+
   /**
    * Get the next item in the iterator, or raise py::StopIteration if the
    * iterator has ended, but without advancing the iterator.
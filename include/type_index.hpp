@@ -0,0 +1,92 @@
+/**
+ * type_index.hpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#ifndef PYHDT_TYPE_INDEX_HPP
+#define PYHDT_TYPE_INDEX_HPP
+
+#include "HDT.hpp"
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+ * TypeIndex is a sidecar index of the types of the entities of a HDT document,
+ * stored next to the HDT file and mapped in memory. It holds, in CSR format,
+ * the sorted types (object IDs) of each subject ID, and the sorted entities
+ * (subject IDs) of each object ID, for a set of type predicates, e.g.,
+ * rdf:type or wdt:P31. The index file is mapped using MappedFile, so it is
+ * shared between processes which open the same index.
+ */
+class TypeIndex {
+private:
+  std::shared_ptr<MappedFile> file;
+  size_t nbTriples;
+  size_t nbSubjects;
+  size_t nbObjects;
+  uint64_t hdtFileSize;
+  uint64_t hdtFileTime;
+  std::vector<size_t> predicates;
+  const uint64_t *typesIndptr;
+  const uint32_t *types;
+  const uint64_t *entitiesIndptr;
+  const uint32_t *entities;
+
+public:
+  /*!
+   * Map an index file in memory. Throws a runtime_error if the file is invalid.
+   * @param path Path of the index file
+   */
+  TypeIndex(std::string path);
+
+  /*!
+   * Build the index of a HDT document, and write it in a file
+   * @param hdt        HDT document to index
+   * @param hdtFile    Path of the HDT file, whose size and modification time are stored in the index
+   * @param predicates IDs of the type predicates
+   * @param path       Path of the index file
+   * @param nbThreads  Number of threads used to read the triples
+   */
+  static void build(hdt::HDT *hdt, std::string hdtFile, std::vector<size_t> predicates,
+                    std::string path, size_t nbThreads);
+
+  /*!
+   * Test if the index was built for a HDT document, with the given type predicates.
+   * The HDT file must have the same size and modification time as when the index was built.
+   * @param  hdt        HDT document
+   * @param  hdtFile    Path of the HDT file
+   * @param  predicates Sorted IDs of the type predicates
+   * @return            True if the index can be used for the HDT document
+   */
+  bool isValidFor(hdt::HDT *hdt, std::string hdtFile, std::vector<size_t> &predicates);
+
+  std::string getPath();
+
+  /*!
+   * Get the sorted IDs of the type predicates of the index
+   * @return IDs of the type predicates
+   */
+  std::vector<size_t> getPredicates();
+
+  /*!
+   * Get the sorted types of a subject, as a range [begin, end) of object IDs
+   * @param subject Subject ID of the entity
+   * @param begin   Output: start of the types
+   * @param end     Output: end of the types
+   */
+  void getTypes(size_t subject, const uint32_t *&begin, const uint32_t *&end);
+
+  /*!
+   * Get the sorted entities of a type, as a range [begin, end) of subject IDs
+   * @param object Object ID of the type
+   * @param begin  Output: start of the entities
+   * @param end    Output: end of the entities
+   */
+  void getEntities(size_t object, const uint32_t *&begin, const uint32_t *&end);
+};
+
+#endif /* PYHDT_TYPE_INDEX_HPP */
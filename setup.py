@@ -21,7 +21,15 @@ sources = [
     "src/hdt_document.cpp",
     "src/triple_iterator.cpp",
     "src/tripleid_iterator.cpp",
-    "src/join_iterator.cpp"
+    "src/join_iterator.cpp",
+    "src/join_operators.cpp",
+    "src/join_planner.cpp",
+    "src/term_filter.cpp",
+    "src/graph_view.cpp",
+    "src/propagation.cpp",
+    "src/hop_results.cpp",
+    "src/type_index.cpp",
+    "src/mapped_file.cpp"
 ]
 
 # HDT source files
@@ -80,6 +88,6 @@ setup(
     long_description=long_description,
     keywords=["hdt", "rdf", "semantic web", "search"],
     license="MIT",
-    install_requires=['pybind11==2.2.4'],
+    install_requires=['pybind11==2.2.4', 'numpy'],
     ext_modules=[hdt_extension]
 )
@@ -0,0 +1,347 @@
+/**
+ * graph_view.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "graph_view.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+using namespace hdt;
+
+// Header of a degree file, followed by the out-degrees then the in-degrees of the nodes.
+// The size and modification time of the HDT file detect a HDT file rebuilt with the same counts.
+struct DegreeFileHeader {
+  char magic[8];
+  uint64_t nbTriples;
+  uint64_t size;
+  uint64_t hdtFileSize;
+  uint64_t hdtFileTime;
+};
+
+static const char DEGREE_FILE_MAGIC[8] = {'P', 'Y', 'H', 'D', 'T', 'D', 'G', '1'};
+
+/*!
+ * Count the triples matching a triple pattern. The indexes of HDT give the
+ * exact count of most patterns without reading the triples, otherwise they
+ * are counted one by one.
+ * @param  triples Triples of the HDT document
+ * @param  pattern Triple pattern made of IDs
+ * @return         Number of matching triples
+ */
+static size_t countMatches(Triples *triples, TripleID &pattern) {
+  IteratorTripleID *it = triples->search(pattern);
+  size_t count = 0;
+  if (it->numResultEstimation() == EXACT) {
+    count = it->estimatedNumResults();
+  } else {
+    while (it->hasNext()) {
+      it->next();
+      count++;
+    }
+  }
+  delete it;
+  return count;
+}
+
+EdgeDirection parseDirection(const std::string &direction) {
+  if (direction == "out") {
+    return OUTGOING;
+  } else if (direction == "in") {
+    return INCOMING;
+  } else if (direction == "both") {
+    return BOTH;
+  }
+  throw std::runtime_error("Unknown direction '" + direction + "', expected 'out', 'in' or 'both'");
+}
+
+void normalizePredicates(std::vector<unsigned int> &predicates) {
+  std::sort(predicates.begin(), predicates.end());
+  predicates.erase(std::unique(predicates.begin(), predicates.end()), predicates.end());
+  predicates.erase(std::remove(predicates.begin(), predicates.end(), 0), predicates.end());
+}
+
+GraphView::GraphView(HDT *_hdt) : hdt(_hdt), mapping(_hdt->getDictionary()) {}
+
+size_t GraphView::getMaxNodeID() const {
+  size_t maxObject = hdt->getDictionary()->getMaxObjectID();
+  return std::max(mapping.nbSubjects, mapping.toGlobal(maxObject, OBJECT));
+}
+
+GlobalIDMapping GraphView::getMapping() const { return mapping; }
+
+size_t GraphView::outDegree(size_t node, size_t predicate) const {
+  size_t subject = mapping.fromGlobal(node, SUBJECT);
+  if (subject == 0 || predicate > hdt->getDictionary()->getNpredicates()) {
+    return 0;
+  }
+  TripleID pattern(subject, predicate, 0);
+  return countMatches(hdt->getTriples(), pattern);
+}
+
+size_t GraphView::inDegree(size_t node, size_t predicate) const {
+  size_t object = mapping.fromGlobal(node, OBJECT);
+  if (object == 0 || object > hdt->getDictionary()->getMaxObjectID() ||
+      predicate > hdt->getDictionary()->getNpredicates()) {
+    return 0;
+  }
+  TripleID pattern(0, predicate, object);
+  return countMatches(hdt->getTriples(), pattern);
+}
+
+/*!
+ * Append the edges matching a triple pattern
+ * @param pattern   Triple pattern made of IDs, with a bound subject or object
+ * @param outgoing  True if the pattern has a bound subject, False if it has a bound object
+ * @param neighbors Output: global IDs of the other end of the edges
+ * @param labels    Output: predicates of the edges
+ */
+void GraphView::appendEdges(TripleID &pattern, bool outgoing, std::vector<unsigned int> &neighbors,
+                            std::vector<unsigned int> &labels) const {
+  IteratorTripleID *it = hdt->getTriples()->search(pattern);
+  while (it->hasNext()) {
+    TripleID *triple = it->next();
+    neighbors.push_back(outgoing ? mapping.toGlobal(triple->getObject(), OBJECT)
+                                 : triple->getSubject());
+    labels.push_back(triple->getPredicate());
+  }
+  delete it;
+}
+
+void GraphView::neighbors(size_t node, EdgeDirection direction,
+                          const std::vector<unsigned int> &predicates,
+                          std::vector<unsigned int> &neighbors,
+                          std::vector<unsigned int> &labels) const {
+  size_t subject = mapping.fromGlobal(node, SUBJECT);
+  size_t object = mapping.fromGlobal(node, OBJECT);
+  if (object > hdt->getDictionary()->getMaxObjectID()) {
+    object = 0;
+  }
+  // with a list of predicates, each one is looked up in the index,
+  // instead of reading and filtering all the edges of the node
+  std::vector<unsigned int> wildcard(1, 0);
+  const std::vector<unsigned int> &lookups = predicates.empty() ? wildcard : predicates;
+  for (size_t i = 0; i < lookups.size(); i++) {
+    if (lookups[i] > hdt->getDictionary()->getNpredicates()) {
+      break;
+    }
+    if (direction != INCOMING && subject != 0) {
+      TripleID pattern(subject, lookups[i], 0);
+      appendEdges(pattern, true, neighbors, labels);
+    }
+  }
+  for (size_t i = 0; i < lookups.size(); i++) {
+    if (lookups[i] > hdt->getDictionary()->getNpredicates()) {
+      break;
+    }
+    if (direction != OUTGOING && object != 0) {
+      TripleID pattern(0, lookups[i], object);
+      appendEdges(pattern, false, neighbors, labels);
+    }
+  }
+}
+
+size_t GraphView::sampleNeighbors(size_t node, EdgeDirection direction,
+                                  const std::vector<unsigned int> &predicates, size_t fanout,
+                                  SplitMix64 &generator, unsigned int *neighbors,
+                                  unsigned int *labels) const {
+  size_t subject = mapping.fromGlobal(node, SUBJECT);
+  size_t object = mapping.fromGlobal(node, OBJECT);
+  if (object > hdt->getDictionary()->getMaxObjectID()) {
+    object = 0;
+  }
+  // the adjacency lists to sample from: one per predicate and direction
+  std::vector<TripleID> patterns;
+  std::vector<unsigned int> wildcard(1, 0);
+  const std::vector<unsigned int> &lookups = predicates.empty() ? wildcard : predicates;
+  for (size_t i = 0; i < lookups.size(); i++) {
+    if (lookups[i] <= hdt->getDictionary()->getNpredicates()) {
+      if (direction != INCOMING && subject != 0) {
+        patterns.push_back(TripleID(subject, lookups[i], 0));
+      }
+      if (direction != OUTGOING && object != 0) {
+        patterns.push_back(TripleID(0, lookups[i], object));
+      }
+    }
+  }
+  std::vector<IteratorTripleID *> iterators;
+  std::vector<size_t> starts(1, 0);
+  bool positional = true;
+  for (size_t i = 0; i < patterns.size(); i++) {
+    iterators.push_back(hdt->getTriples()->search(patterns[i]));
+    positional = positional && iterators[i]->canGoTo() &&
+                 iterators[i]->numResultEstimation() == EXACT;
+    starts.push_back(starts.back() + iterators[i]->estimatedNumResults());
+  }
+  size_t nbEdges = starts.back();
+  size_t nbDrawn = 0;
+  if (nbEdges <= fanout || !positional) {
+    // read all edges, then keep a random subset of them if needed
+    std::vector<unsigned int> all, allLabels;
+    for (size_t i = 0; i < patterns.size(); i++) {
+      while (iterators[i]->hasNext()) {
+        TripleID *triple = iterators[i]->next();
+        all.push_back(patterns[i].getSubject() != 0 ? mapping.toGlobal(triple->getObject(), OBJECT)
+                                                    : triple->getSubject());
+        allLabels.push_back(triple->getPredicate());
+      }
+    }
+    // partial Fisher-Yates shuffle
+    nbDrawn = std::min(fanout, all.size());
+    for (size_t i = 0; i < nbDrawn; i++) {
+      size_t j = i + generator.below(all.size() - i);
+      std::swap(all[i], all[j]);
+      std::swap(allLabels[i], allLabels[j]);
+      neighbors[i] = all[i];
+      labels[i] = allLabels[i];
+    }
+  } else {
+    // Floyd's algorithm draws distinct positions in fanout steps. Fanouts are
+    // small, so a linear search for duplicates is cheaper than a set.
+    std::vector<size_t> positions;
+    for (size_t j = nbEdges - fanout; j < nbEdges; j++) {
+      size_t position = generator.below(j + 1);
+      if (std::find(positions.begin(), positions.end(), position) != positions.end()) {
+        position = j;
+      }
+      positions.push_back(position);
+    }
+    std::sort(positions.begin(), positions.end());
+    size_t range = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+      while (positions[i] >= starts[range + 1]) {
+        range++;
+      }
+      iterators[range]->goTo(positions[i] - starts[range]);
+      TripleID *triple = iterators[range]->next();
+      neighbors[i] = patterns[range].getSubject() != 0
+                         ? mapping.toGlobal(triple->getObject(), OBJECT)
+                         : triple->getSubject();
+      labels[i] = triple->getPredicate();
+    }
+    nbDrawn = positions.size();
+  }
+  for (size_t i = 0; i < iterators.size(); i++) {
+    delete iterators[i];
+  }
+  return nbDrawn;
+}
+
+size_t GraphView::randomWalk(size_t start, const WalkOptions &options, uint64_t seed,
+                             unsigned int *walk) const {
+  SplitMix64 generator(seed);
+  bool biased = options.p != 1.0 || options.q != 1.0;
+  double maxWeight = std::max(1.0, std::max(1.0 / options.p, 1.0 / options.q));
+  // sorted neighbors of the previous node, only read for biased walks
+  std::vector<unsigned int> previous, labels;
+  unsigned int next, label;
+  walk[0] = start;
+  size_t size = 1;
+  while (size < options.length) {
+    size_t node = walk[size - 1];
+    // each step jumps to a single random edge, instead of reading all of them
+    if (sampleNeighbors(node, options.direction, options.predicates, 1, generator, &next,
+                        &label) == 0) {
+      break;
+    }
+    if (biased && size > 1) {
+      // rejection sampling: a neighbor drawn uniformly is accepted with a
+      // probability proportional to its weight, so weights are never computed
+      // for all neighbors
+      unsigned int last = walk[size - 2];
+      while (true) {
+        double weight = 1.0 / options.q;
+        if (next == last) {
+          weight = 1.0 / options.p;
+        } else if (std::binary_search(previous.begin(), previous.end(), next)) {
+          weight = 1.0;
+        }
+        if (generator.uniform() * maxWeight < weight) {
+          break;
+        }
+        sampleNeighbors(node, options.direction, options.predicates, 1, generator, &next, &label);
+      }
+    }
+    walk[size++] = next;
+    if (biased && size < options.length) {
+      previous.clear();
+      labels.clear();
+      neighbors(node, options.direction, options.predicates, previous, labels);
+      std::sort(previous.begin(), previous.end());
+    }
+  }
+  return size;
+}
+
+void GraphView::allDegrees(DegreeTable &table) const {
+  table.size = getMaxNodeID() + 1;
+  table.values.assign(2 * table.size, 0);
+  unsigned int *outDegrees = table.values.data();
+  unsigned int *inDegrees = outDegrees + table.size;
+  TripleID pattern(0, 0, 0);
+  IteratorTripleID *it = hdt->getTriples()->search(pattern);
+  while (it->hasNext()) {
+    TripleID *triple = it->next();
+    outDegrees[triple->getSubject()]++;
+    inDegrees[mapping.toGlobal(triple->getObject(), OBJECT)]++;
+  }
+  delete it;
+  table.outDegrees = outDegrees;
+  table.inDegrees = inDegrees;
+}
+
+/*!
+ * Map a degree file, or return NULL if it is missing or was built for another graph
+ * @param  path     Path of the degree file
+ * @param  expected Header of the degree file of the graph
+ * @return          Degrees held by the mapped file, or NULL
+ */
+static std::shared_ptr<DegreeTable> mapDegrees(std::string path, const DegreeFileHeader &expected) {
+  std::shared_ptr<MappedFile> file;
+  try {
+    file = MappedFile::open(path);
+  } catch (const std::runtime_error &) {
+    return std::shared_ptr<DegreeTable>();
+  }
+  const DegreeFileHeader *header = (const DegreeFileHeader *) file->getData();
+  if (file->getSize() != sizeof(DegreeFileHeader) + 2 * expected.size * sizeof(unsigned int) ||
+      memcmp(header, &expected, sizeof(DegreeFileHeader)) != 0) {
+    return std::shared_ptr<DegreeTable>();
+  }
+  std::shared_ptr<DegreeTable> table = std::make_shared<DegreeTable>();
+  table->size = expected.size;
+  table->outDegrees = (const unsigned int *) (header + 1);
+  table->inDegrees = table->outDegrees + expected.size;
+  table->file = file;
+  return table;
+}
+
+std::shared_ptr<DegreeTable> GraphView::sharedDegrees(std::string path, std::string hdtFile) const {
+  DegreeFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DEGREE_FILE_MAGIC, sizeof(header.magic));
+  header.nbTriples = hdt->getTriples()->getNumberOfElements();
+  header.size = getMaxNodeID() + 1;
+  struct stat info;
+  if (!hdtFile.empty() && stat(hdtFile.c_str(), &info) == 0) {
+    header.hdtFileSize = info.st_size;
+    header.hdtFileTime = info.st_mtime;
+  }
+  std::shared_ptr<DegreeTable> table = mapDegrees(path, header);
+  if (table) {
+    return table;
+  }
+  table = std::make_shared<DegreeTable>();
+  allDegrees(*table);
+  try {
+    MappedFile::write(path, {{&header, sizeof(header)},
+                             {table->values.data(), table->values.size() * sizeof(unsigned int)}});
+  } catch (const std::runtime_error &) {
+    // e.g., a read-only directory: keep the degrees in memory
+    return table;
+  }
+  std::shared_ptr<DegreeTable> mapped = mapDegrees(path, header);
+  return mapped ? mapped : table;
+}
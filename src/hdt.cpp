@@ -6,6 +6,7 @@
 #include "triple_iterator.hpp"
 #include "tripleid_iterator.hpp"
 #include "join_iterator.hpp"
+#include "hop_results.hpp"
 
 namespace py = pybind11;
 
@@ -13,10 +14,13 @@ PYBIND11_MODULE(hdt, m) {
   m.doc() = MODULE_DOC;
 
   py::class_<TripleIterator>(m, "TripleIterator", TRIPLE_ITERATOR_CLASS_DOC)
-      .def("next", &TripleIterator::next, TRIPLE_ITERATOR_NEXT_DOC)
-      .def("__next__", &TripleIterator::next, TRIPLE_ITERATOR_NEXT_DOC)
-      .def("peek", &TripleIterator::peek, TRIPLE_ITERATOR_PEEK_DOC)
-      .def("has_next", &TripleIterator::hasNext, TRIPLE_ITERATOR_HASNEXT_DOC)
+      .def("next", &TripleIterator::python_next, TRIPLE_ITERATOR_NEXT_DOC)
+      .def("__next__", &TripleIterator::python_next, TRIPLE_ITERATOR_NEXT_DOC)
+      .def("next_batch", &TripleIterator::python_nextBatch,
+           TRIPLE_ITERATOR_NEXT_BATCH_DOC, py::arg("n"))
+      .def("peek", &TripleIterator::python_peek, TRIPLE_ITERATOR_PEEK_DOC)
+      .def("has_next", &TripleIterator::hasNext, TRIPLE_ITERATOR_HASNEXT_DOC,
+           py::call_guard<py::gil_scoped_release>())
       .def("size_hint", &TripleIterator::sizeHint, TRIPLE_ITERATOR_SIZE_DOC)
       .def("__len__", &TripleIterator::sizeHint,
            TRIPLE_ITERATOR_SIZE_DOC)
@@ -38,6 +42,8 @@ PYBIND11_MODULE(hdt, m) {
   py::class_<TripleIDIterator>(m, "TripleIDIterator", TRIPLE_ID_ITERATOR_CLASS_DOC)
       .def("next", &TripleIDIterator::next, TRIPLE_ITERATOR_NEXT_DOC)
       .def("__next__", &TripleIDIterator::next, TRIPLE_ITERATOR_NEXT_DOC)
+      .def("next_batch", &TripleIDIterator::nextBatch,
+           TRIPLE_ID_ITERATOR_NEXT_BATCH_DOC, py::arg("n"))
       .def("peek", &TripleIDIterator::peek, TRIPLE_ITERATOR_PEEK_DOC)
       .def("has_next", &TripleIDIterator::hasNext, TRIPLE_ITERATOR_HASNEXT_DOC)
       .def("size_hint", &TripleIDIterator::sizeHint, TRIPLE_ITERATOR_SIZE_DOC)
@@ -58,16 +64,25 @@ PYBIND11_MODULE(hdt, m) {
       .def("__repr__", &TripleIDIterator::python_repr);
 
   py::class_<JoinIterator>(m, "JoinIterator")
-    .def("next", &JoinIterator::next)
+    .def("next", &JoinIterator::next, py::call_guard<py::gil_scoped_release>())
     .def("has_next", &JoinIterator::hasNext)
     .def("cardinality", &JoinIterator::estimatedCardinality)
     .def("reset", &JoinIterator::reset)
     .def("__len__", &JoinIterator::estimatedCardinality)
-    .def("__next__", &JoinIterator::next)
+    .def("__next__", &JoinIterator::next, py::call_guard<py::gil_scoped_release>())
     .def("__iter__", &JoinIterator::python_iter);
 
+  py::class_<HopResults>(m, "HopResults", HOP_RESULTS_CLASS_DOC)
+      .def("page", &HopResults::page, HOP_RESULTS_PAGE_DOC, py::arg("limit"),
+           py::arg("offset") = 0)
+      .def("__len__", &HopResults::size, HOP_RESULTS_SIZE_DOC)
+      .def_property_readonly("entities", &HopResults::getEntities,
+                             HOP_RESULTS_ENTITIES_DOC)
+      .def("__repr__", &HopResults::python_repr);
+
   py::class_<HDTDocument>(m, "HDTDocument", HDT_DOCUMENT_CLASS_DOC)
       .def(py::init(&HDTDocument::create))
+      .def(py::pickle(&HDTDocument::getState, &HDTDocument::fromState))
       .def_property_readonly("file_path", &HDTDocument::getFilePath,
                              HDT_DOCUMENT_GETFILEPATH_DOC)
       .def_property_readonly("total_triples", &HDTDocument::getNbTriples,
@@ -83,22 +98,103 @@ PYBIND11_MODULE(hdt, m) {
       .def("search_triples", &HDTDocument::search,
            HDT_DOCUMENT_SEARCH_TRIPLES_DOC, py::arg("subject"),
            py::arg("predicate"), py::arg("object"), py::arg("limit") = 0,
-           py::arg("offset") = 0)
-      .def("search_join", &HDTDocument::searchJoin)
-      .def("configure_hops", &HDTDocument::configureHops)
+           py::arg("offset") = 0,
+           py::arg("filters") = std::vector<filter_expr>(),
+           py::arg("prefetch") = 0, py::arg("raw") = false)
+      .def("search_join", &HDTDocument::searchJoin,
+           HDT_DOCUMENT_SEARCH_JOIN_DOC, py::arg("patterns"),
+           py::arg("memory_budget") = HASH_JOIN_DEFAULT_MEMORY_BUDGET,
+           py::arg("threads") = 1, py::arg("limit") = 0, py::arg("offset") = 0,
+           py::arg("filters") = std::vector<filter_expr>())
+      .def("configure_joins", &HDTDocument::configureJoins, HDT_DOCUMENT_CONFIGURE_JOINS_DOC,
+           py::arg("hash_join_min_cardinality") = HASH_JOIN_MIN_CARDINALITY,
+           py::arg("parallel_min_cardinality") = PARALLEL_MIN_CARDINALITY)
+      .def("configure_hops", &HDTDocument::configureHops, HDT_DOCUMENT_CONFIGURE_HOPS_DOC,
+           py::arg("num_hops"), py::arg("predicates"), py::arg("prefix"),
+           py::arg("continuous_dictionary"), py::arg("include_literals"),
+           py::arg("max_out_degree") = 0, py::arg("max_in_degree") = 0,
+           py::arg("truncate_hubs") = false)
+      .def_property_readonly("nb_hubs", &HDTDocument::getNbHubs, HDT_DOCUMENT_NB_HUBS_DOC)
       .def("compute_all_hops", &HDTDocument::computeAllHopsIDs)
+      .def("configure_hop_cache", &HDTDocument::configureHopCache,
+           HDT_DOCUMENT_CONFIGURE_HOP_CACHE_DOC, py::arg("max_bytes"))
+      .def("hop_cache_stats", &HDTDocument::hopCacheStats, HDT_DOCUMENT_HOP_CACHE_STATS_DOC)
+      .def("clear_hop_cache", &HDTDocument::clearHopCache, HDT_DOCUMENT_CLEAR_HOP_CACHE_DOC)
       .def("cloneHDT", &HDTDocument::cloneHDT)
       .def("compute_hops", &HDTDocument::computeHopsIDs)
+      .def("compute_hops_paged", &HDTDocument::computeHopsPaged,
+           HDT_DOCUMENT_COMPUTE_HOPS_PAGED_DOC, py::arg("terms"))
+      .def("compute_all_hops_arrays", &HDTDocument::computeAllHopsArrays,
+           HDT_DOCUMENT_COMPUTE_HOPS_ARRAYS_DOC, py::arg("terms"))
+      .def("compute_hops_arrays", &HDTDocument::computeHopsArrays,
+           HDT_DOCUMENT_COMPUTE_HOPS_ARRAYS_DOC, py::arg("terms"), py::arg("limit"),
+           py::arg("offset"))
+      .def("propagate", &HDTDocument::propagate, HDT_DOCUMENT_PROPAGATE_DOC,
+           py::arg("terms"), py::arg("seeds") = std::vector<unsigned int>(),
+           py::arg("weights") = std::map<unsigned int, double>(),
+           py::arg("default_weight") = 1.0, py::arg("iterations") = 10,
+           py::arg("mode") = "ppr", py::arg("alpha") = 0.15, py::arg("threads") = 0)
       .def("filter_types", &HDTDocument::filterTypeIDs)
       .def("remove", &HDTDocument::remove)
       .def("string_to_id", &HDTDocument::StringToid)
       .def("id_to_string", &HDTDocument::idToString)
       .def("string_to_global_id", &HDTDocument::StringToGlobalId)
       .def("global_id_to_string", &HDTDocument::globalIdToString)
+      .def("to_global_ids", &HDTDocument::toGlobalIDs, HDT_DOCUMENT_TO_GLOBAL_IDS_DOC,
+           py::arg("ids"), py::arg("role"))
+      .def("from_global_ids", &HDTDocument::fromGlobalIDs, HDT_DOCUMENT_FROM_GLOBAL_IDS_DOC,
+           py::arg("ids"))
       .def("search_triples_ids", &HDTDocument::searchIDs,
            HDT_DOCUMENT_SEARCH_TRIPLES_IDS_DOC, py::arg("subject"),
            py::arg("predicate"), py::arg("object"), py::arg("limit") = 0,
-           py::arg("offset") = 0)
+           py::arg("offset") = 0,
+           py::arg("filters") = std::vector<filter_expr>())
+      .def("contains", &HDTDocument::containsIDs, HDT_DOCUMENT_CONTAINS_DOC,
+           py::arg("subject"), py::arg("predicate"), py::arg("object"))
+      .def("contains", &HDTDocument::contains, HDT_DOCUMENT_CONTAINS_DOC,
+           py::arg("subject"), py::arg("predicate"), py::arg("object"))
+      .def("contains_many", &HDTDocument::containsMany,
+           HDT_DOCUMENT_CONTAINS_MANY_DOC, py::arg("patterns"), py::arg("threads") = 0)
+      .def("out_degree", &HDTDocument::outDegree, HDT_DOCUMENT_OUT_DEGREE_DOC,
+           py::arg("ids"), py::arg("predicate") = 0, py::arg("cache") = false,
+           py::arg("threads") = 0, py::arg("cache_path") = "")
+      .def("in_degree", &HDTDocument::inDegree, HDT_DOCUMENT_IN_DEGREE_DOC,
+           py::arg("ids"), py::arg("predicate") = 0, py::arg("cache") = false,
+           py::arg("threads") = 0, py::arg("cache_path") = "")
+      .def("neighbors", &HDTDocument::neighbors, HDT_DOCUMENT_NEIGHBORS_DOC,
+           py::arg("ids"), py::arg("direction") = "out",
+           py::arg("predicates") = std::vector<unsigned int>(), py::arg("threads") = 0)
+      .def("sample_triples", &HDTDocument::sampleTriples, HDT_DOCUMENT_SAMPLE_TRIPLES_DOC,
+           py::arg("n"), py::arg("pattern") = py::none(),
+           py::arg("seed") = -1, py::arg("threads") = 0)
+      .def("random_walks", &HDTDocument::randomWalks, HDT_DOCUMENT_RANDOM_WALKS_DOC,
+           py::arg("ids"), py::arg("walks_per_node") = 1, py::arg("length") = 10,
+           py::arg("direction") = "out", py::arg("predicates") = std::vector<unsigned int>(),
+           py::arg("p") = 1.0, py::arg("q") = 1.0, py::arg("seed") = -1,
+           py::arg("threads") = 0)
+      .def("write_random_walks", &HDTDocument::writeRandomWalks,
+           HDT_DOCUMENT_WRITE_RANDOM_WALKS_DOC, py::arg("path"), py::arg("ids"),
+           py::arg("walks_per_node") = 1, py::arg("length") = 10,
+           py::arg("direction") = "out", py::arg("predicates") = std::vector<unsigned int>(),
+           py::arg("p") = 1.0, py::arg("q") = 1.0, py::arg("seed") = -1,
+           py::arg("threads") = 0)
+      .def("negative_samples", &HDTDocument::negativeSamples,
+           HDT_DOCUMENT_NEGATIVE_SAMPLES_DOC, py::arg("positives"), py::arg("k") = 1,
+           py::arg("mode") = "tail", py::arg("filtered") = true, py::arg("seed") = -1,
+           py::arg("threads") = 0)
+      .def("sample_neighborhood", &HDTDocument::sampleNeighborhood,
+           HDT_DOCUMENT_SAMPLE_NEIGHBORHOOD_DOC, py::arg("ids"), py::arg("fanouts"),
+           py::arg("direction") = "out", py::arg("predicates") = std::vector<unsigned int>(),
+           py::arg("seed") = -1, py::arg("threads") = 0)
+      .def("load_type_index", &HDTDocument::loadTypeIndex,
+           HDT_DOCUMENT_LOAD_TYPE_INDEX_DOC,
+           py::arg("predicates") = std::vector<std::string>({"http://www.w3.org/1999/02/22-rdf-syntax-ns#type"}),
+           py::arg("path") = "", py::arg("threads") = 0)
+      .def("types_of", &HDTDocument::typesOf, HDT_DOCUMENT_TYPES_OF_DOC, py::arg("ids"))
+      .def("search_many", &HDTDocument::searchManyIDs,
+           HDT_DOCUMENT_SEARCH_MANY_DOC, py::arg("patterns"), py::arg("limit") = 0)
+      .def("search_many", &HDTDocument::searchMany,
+           HDT_DOCUMENT_SEARCH_MANY_DOC, py::arg("patterns"), py::arg("limit") = 0)
       .def("tripleid_to_string", &HDTDocument::idsToString,
            HDT_DOCUMENT_TRIPLES_IDS_TO_STRING_DOC,
            py::arg("subject"), py::arg("predicate"), py::arg("object"))
@@ -4,19 +4,66 @@
  */
 
 #include "hdt_document.hpp"
+#include "join_planner.hpp"
+#include "thread_utils.hpp"
 #include "triple_iterator.hpp"
 #include <HDTEnums.hpp>
 #include <HDTManager.hpp>
 #include <SingleTriple.hpp>
 #include <fstream>
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <mutex>
 #include <pybind11/stl.h>
+#include <random>
+#include <unordered_map>
 
 #include "../hdt-cpp-1.3.2/libhdt/src/triples/TriplesList.hpp"
 #include "../hdt-cpp-1.3.2/libhdt/src/triples/TriplesComparator.hpp"
 
 using namespace hdt;
 
+// When checking the existence of several triples sharing the same subject and
+// predicate, the adjacency list is scanned if it holds at most this number
+// of objects per probe, instead of searching each triple
+static const size_t CONTAINS_SCAN_FACTOR = 8;
+
+// Number of blocks of nodes per thread when reading adjacency lists,
+// to balance the load between threads when degrees are skewed
+static const size_t NEIGHBORS_BLOCKS_PER_THREAD = 8;
+
+// Number of random walks computed before writing them to a file
+static const size_t RANDOM_WALKS_BATCH_SIZE = 65536;
+
+// Maximum number of entities drawn to corrupt a triple, before giving up
+// when all corrupted triples are found in the HDT document
+static const size_t NEGATIVE_SAMPLES_MAX_ATTEMPTS = 100;
+
+// Relative cost of checking the types of a term, compared to reading a
+// subject of a class from the object index
+static const size_t FILTER_TYPES_PROBE_COST = 4;
+
+// HDT files mapped by this process, indexed by canonical path, so that
+// documents opened on the same file share them
+static std::map<std::string, std::shared_ptr<OpenedHDT>> openedHDTs;
+static std::mutex openedHDTsMutex;
+
+/*!
+ * Get the canonical path of a file, used to identify the HDT files mapped by this process
+ * @param  file Path of the file
+ * @return      Canonical path, or the given path if the file cannot be resolved
+ */
+static std::string canonicalPath(const std::string &file) {
+  char *path = realpath(file.c_str(), NULL);
+  if (path == NULL) {
+    return file;
+  }
+  std::string result(path);
+  free(path);
+  return result;
+}
+
 /*!
  * Skip `offset` items from an iterator, optimized for HDT iterators.
  * @param it          [description]
@@ -61,8 +108,19 @@ HDTDocument::HDTDocument(std::string file) {
 	  if (!file_exists(file)) {
 	    throw std::runtime_error("Cannot open HDT file '" + file + "': Not Found!");
 	  }
-	  hdt = HDTManager::mapIndexedHDT(file.c_str());
-	  processor = new QueryProcessor(hdt);
+	  // reuse the mapping of the file if this process already opened it, e.g., to unpickle a document
+	  std::lock_guard<std::mutex> lock(openedHDTsMutex);
+	  std::shared_ptr<OpenedHDT> &opened = openedHDTs[canonicalPath(file)];
+	  if (!opened){
+		  hdt = HDTManager::mapIndexedHDT(file.c_str());
+		  opened = std::make_shared<OpenedHDT>(hdt,new QueryProcessor(hdt));
+	  }
+	  openedFile = opened;
+	  hdt = opened->hdt;
+	  processor = opened->processor;
+	  decodeMutex = opened->decodeMutex;
+  } else {
+	  decodeMutex = std::make_shared<std::mutex>();
   }
   numHops=1;
   filterPrefixStr="";
@@ -75,6 +133,14 @@ HDTDocument::HDTDocument(std::string file) {
   preffixIniOBJECT=0;
   preffixEndOBJECT=0;
   literalEndID=0;
+  includeLiterals=false;
+  hopConfigHash=0;
+  maxOutDegree=0;
+  maxInDegree=0;
+  truncateHubs=false;
+  nbHubs=0;
+  hashJoinMinCardinality=HASH_JOIN_MIN_CARDINALITY;
+  parallelMinCardinality=PARALLEL_MIN_CARDINALITY;
 }
 
 
@@ -99,21 +165,27 @@ std::string HDTDocument::python_repr() {
 }
 
 /*!
- * Search all matching triples for a triple pattern, whith an optional limit and
- * offset. Returns a tuple<vector<triples>, cardinality>
+ * Search all matching triples for a triple pattern, whith an optional limit,
+ * offset and filters. Returns a tuple<vector<triples>, cardinality>
  * @param subject   [description]
  * @param predicate [description]
  * @param object    [description]
  * @param limit     [description]
  * @param offset    [description]
+ * @param filters   Filters on the triple positions
+ * @param prefetch  Maximum number of decoded triples waiting to be consumed, 0 to disable prefetching
+ * @param raw       If True, RDF terms are returned as bytes, without UTF-8 decoding
  */
 search_results HDTDocument::search(std::string subject,
                                    std::string predicate,
                                    std::string object,
                                    unsigned int limit,
-                                   unsigned int offset) {
-  search_results_ids tRes = searchIDs(subject, predicate, object, limit, offset);
-  TripleIterator *resultIterator = new TripleIterator(std::get<0>(tRes), hdt->getDictionary());
+                                   unsigned int offset,
+                                   std::vector<filter_expr> filters,
+                                   size_t prefetch, bool raw) {
+  search_results_ids tRes = searchIDs(subject, predicate, object, limit, offset, filters);
+  TripleIterator *resultIterator =
+      new TripleIterator(std::get<0>(tRes), hdt->getDictionary(), decodeMutex, prefetch, raw);
   return std::make_tuple(resultIterator, std::get<1>(tRes));
 }
 
@@ -125,17 +197,39 @@ search_results HDTDocument::search(std::string subject,
  * @param object    [description]
  * @param limit     [description]
  * @param offset    [description]
+ * @param filters   Filters on the triple positions
  */
 search_results_ids HDTDocument::searchIDs(std::string subject,
                                           std::string predicate,
                                           std::string object,
                                           unsigned int limit,
-                                          unsigned int offset) {
+                                          unsigned int offset,
+                                          std::vector<filter_expr> filters) {
+  // compile filters first, so invalid filters are reported before searching.
+  // Compiling filters decodes terms, like resolving the pattern.
+  std::unique_lock<std::mutex> lock(*decodeMutex);
+  const std::string positions[3] = {"subject", "predicate", "object"};
+  std::vector<TermFilter> termFilters;
+  for (auto it = filters.begin(); it != filters.end(); it++) {
+    int position = (it->size() > 0) ? std::find(positions, positions + 3, it->at(0)) - positions : 3;
+    if (position == 3) {
+      throw std::runtime_error("Filters on triple patterns must target the 'subject', 'predicate' or 'object'");
+    }
+    termFilters.push_back(TermFilter(hdt->getDictionary(), *it, position));
+  }
+
   TripleID tp(hdt->getDictionary()->stringToId(subject, hdt::SUBJECT),
               hdt->getDictionary()->stringToId(predicate, hdt::PREDICATE),
               hdt->getDictionary()->stringToId(object, hdt::OBJECT));
+  lock.unlock();
   IteratorTripleID *it = hdt->getTriples()->search(tp);
   size_t cardinality = it->estimatedNumResults();
+  if (termFilters.size() > 0) {
+    // the offset counts filtered triples, so it is applied by the iterator
+    TripleIDIterator *resultIterator =
+        new TripleIDIterator(it, subject, predicate, object, limit, offset, termFilters);
+    return std::make_tuple(resultIterator, cardinality);
+  }
   // apply offset
   applyOffset<IteratorTripleID>(it, offset, cardinality);
   TripleIDIterator *resultIterator =
@@ -143,6 +237,932 @@ search_results_ids HDTDocument::searchIDs(std::string subject,
   return std::make_tuple(resultIterator, cardinality);
 }
 
+/*!
+ * Search a batch of triple patterns in a single call.
+ * Returns the matching triples ids, grouped by pattern in CSR format.
+ * @param patterns Triple patterns, as (subject, predicate, object)
+ * @param limit    Maximum number of triples per pattern, 0 for no limit
+ */
+csr_triples HDTDocument::searchMany(std::vector<triple> patterns, unsigned int limit) {
+  const hdt::TripleComponentRole roles[3] = {hdt::SUBJECT, hdt::PREDICATE, hdt::OBJECT};
+  std::vector<TripleID> patternIDs;
+  std::vector<bool> valid;
+  std::vector<uint64_t> offsets;
+  std::vector<unsigned int> triples;
+  {
+    py::gil_scoped_release release;
+    std::unique_lock<std::mutex> lock(*decodeMutex);
+    // batches often repeat the same terms, e.g., the predicate
+    std::unordered_map<std::string, size_t> cache[3];
+    std::string terms[3];
+    for (auto it = patterns.begin(); it != patterns.end(); it++) {
+      std::tie(terms[0], terms[1], terms[2]) = *it;
+      size_t ids[3] = {0, 0, 0};
+      bool isValid = true;
+      for (int i = 0; i < 3; i++) {
+        if (terms[i].empty()) {
+          continue;
+        }
+        auto cached = cache[i].find(terms[i]);
+        if (cached == cache[i].end()) {
+          cached = cache[i].emplace(terms[i], hdt->getDictionary()->stringToId(terms[i], roles[i])).first;
+        }
+        ids[i] = cached->second;
+        // unknown RDF terms match nothing
+        isValid = isValid && ids[i] != 0;
+      }
+      patternIDs.push_back(TripleID(ids[0], ids[1], ids[2]));
+      valid.push_back(isValid);
+    }
+    lock.unlock();
+    evaluateMany(patternIDs, valid, limit, offsets, triples);
+  }
+  return std::make_tuple(toArray(std::move(offsets)), toArray(std::move(triples), 3));
+}
+
+/*!
+ * Same as searchMany, but for an array of shape (n, 3) of triple patterns made of IDs
+ * @param patterns Array of shape (n, 3) of triple patterns made of IDs
+ * @param limit    Maximum number of triples per pattern, 0 for no limit
+ */
+csr_triples HDTDocument::searchManyIDs(py::array_t<unsigned int> patterns, unsigned int limit) {
+  if (patterns.ndim() != 2 || patterns.shape(1) != 3) {
+    throw std::runtime_error("Triple patterns must be an array of shape (n, 3)");
+  }
+  auto view = patterns.unchecked<2>();
+  Dictionary *dict = hdt->getDictionary();
+  std::vector<TripleID> patternIDs;
+  std::vector<bool> valid;
+  for (py::ssize_t i = 0; i < patterns.shape(0); i++) {
+    patternIDs.push_back(TripleID(view(i, 0), view(i, 1), view(i, 2)));
+    // IDs outside of the dictionary match nothing
+    valid.push_back(view(i, 0) <= dict->getMaxSubjectID() && view(i, 1) <= dict->getNpredicates() &&
+                    view(i, 2) <= dict->getMaxObjectID());
+  }
+  std::vector<uint64_t> offsets;
+  std::vector<unsigned int> triples;
+  {
+    py::gil_scoped_release release;
+    evaluateMany(patternIDs, valid, limit, offsets, triples);
+  }
+  return std::make_tuple(toArray(std::move(offsets)), toArray(std::move(triples), 3));
+}
+
+/*!
+ * Evaluate a batch of triple patterns made of IDs. Patterns are evaluated
+ * sorted by subject and object, so consecutive searches read close regions
+ * of the triples index, and duplicated patterns are only evaluated once.
+ * @param patterns Triple patterns made of IDs, where 0 is a variable
+ * @param valid    False for patterns which cannot match, e.g., with unknown RDF terms
+ * @param limit    Maximum number of triples per pattern, 0 for no limit
+ * @param offsets  Output: the triples of pattern i are the rows offsets[i] to offsets[i + 1] - 1
+ * @param triples  Output: the matching triples, 3 IDs per triple
+ */
+void HDTDocument::evaluateMany(std::vector<TripleID> &patterns, std::vector<bool> &valid,
+                               unsigned int limit, std::vector<uint64_t> &offsets,
+                               std::vector<unsigned int> &triples) {
+  std::vector<size_t> order(patterns.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&patterns](size_t a, size_t b) {
+    const TripleID &x = patterns[a], &y = patterns[b];
+    if (x.getSubject() != y.getSubject()) {
+      return x.getSubject() < y.getSubject();
+    } else if (x.getObject() != y.getObject()) {
+      return x.getObject() < y.getObject();
+    }
+    return x.getPredicate() < y.getPredicate();
+  });
+
+  // evaluate patterns in sorted order, and remember where the results of each one are
+  std::vector<unsigned int> results;
+  std::vector<size_t> start(patterns.size(), 0);
+  std::vector<size_t> count(patterns.size(), 0);
+  size_t previous = patterns.size();
+  for (auto it = order.begin(); it != order.end(); it++) {
+    size_t index = *it;
+    if (!valid[index]) {
+      continue;
+    }
+    if (previous < patterns.size() && patterns[previous] == patterns[index]) {
+      start[index] = start[previous];
+      count[index] = count[previous];
+      continue;
+    }
+    start[index] = results.size() / 3;
+    IteratorTripleID *iterator = hdt->getTriples()->search(patterns[index]);
+    while (iterator->hasNext() && (limit == 0 || count[index] < limit)) {
+      TripleID *triple = iterator->next();
+      results.push_back(triple->getSubject());
+      results.push_back(triple->getPredicate());
+      results.push_back(triple->getObject());
+      count[index]++;
+    }
+    delete iterator;
+    previous = index;
+  }
+
+  // group results by input pattern
+  offsets.assign(patterns.size() + 1, 0);
+  for (size_t i = 0; i < patterns.size(); i++) {
+    offsets[i + 1] = offsets[i] + count[i];
+  }
+  triples.resize(offsets.back() * 3);
+  for (size_t i = 0; i < patterns.size(); i++) {
+    std::copy(results.begin() + start[i] * 3, results.begin() + (start[i] + count[i]) * 3,
+              triples.begin() + offsets[i] * 3);
+  }
+}
+
+/*!
+ * Test if the HDT document contains a triple matching a triple pattern
+ * @param subject   Subject of the pattern, or an empty string for a variable
+ * @param predicate Predicate of the pattern, or an empty string for a variable
+ * @param object    Object of the pattern, or an empty string for a variable
+ */
+bool HDTDocument::contains(std::string subject, std::string predicate, std::string object) {
+  const hdt::TripleComponentRole roles[3] = {hdt::SUBJECT, hdt::PREDICATE, hdt::OBJECT};
+  const std::string terms[3] = {subject, predicate, object};
+  unsigned int ids[3] = {0, 0, 0};
+  {
+    std::lock_guard<std::mutex> lock(*decodeMutex);
+    for (int i = 0; i < 3; i++) {
+      if (!terms[i].empty()) {
+        ids[i] = hdt->getDictionary()->stringToId(terms[i], roles[i]);
+        // unknown RDF terms match nothing
+        if (ids[i] == 0) {
+          return false;
+        }
+      }
+    }
+  }
+  py::gil_scoped_release release;
+  return containsIDs(ids[0], ids[1], ids[2]);
+}
+
+/*!
+ * Same as contains, but for a triple pattern made of IDs
+ * @param subject   Subject ID of the pattern, or 0 for a variable
+ * @param predicate Predicate ID of the pattern, or 0 for a variable
+ * @param object    Object ID of the pattern, or 0 for a variable
+ */
+bool HDTDocument::containsIDs(unsigned int subject, unsigned int predicate, unsigned int object) {
+  Dictionary *dict = hdt->getDictionary();
+  // IDs out of the dictionary cannot match anything
+  if (subject > dict->getMaxSubjectID() || predicate > dict->getNpredicates() ||
+      object > dict->getMaxObjectID()) {
+    return false;
+  }
+  TripleID pattern(subject, predicate, object);
+  IteratorTripleID *it = hdt->getTriples()->search(pattern);
+  bool found = it->hasNext();
+  delete it;
+  return found;
+}
+
+/*!
+ * Vectorized version of containsIDs. Probes are sorted, then grouped by
+ * subject and predicate, and groups are checked in parallel.
+ * @param patterns Array of shape (n, 3) of triple patterns made of IDs, where 0 is a variable
+ * @param threads  Number of threads, 0 to use all hardware threads
+ */
+py::array_t<bool> HDTDocument::containsMany(py::array_t<unsigned int> patterns, int threads) {
+  if (patterns.ndim() != 2 || patterns.shape(1) != 3) {
+    throw std::runtime_error("Triple patterns must be an array of shape (n, 3)");
+  }
+  auto view = patterns.unchecked<2>();
+  std::vector<TripleID> probes;
+  for (py::ssize_t i = 0; i < patterns.shape(0); i++) {
+    probes.push_back(TripleID(view(i, 0), view(i, 1), view(i, 2)));
+  }
+  std::vector<uint8_t> results(probes.size(), 0);
+  {
+    py::gil_scoped_release release;
+    std::vector<size_t> order(probes.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&probes](size_t a, size_t b) {
+      const TripleID &x = probes[a], &y = probes[b];
+      if (x.getSubject() != y.getSubject()) {
+        return x.getSubject() < y.getSubject();
+      } else if (x.getPredicate() != y.getPredicate()) {
+        return x.getPredicate() < y.getPredicate();
+      }
+      return x.getObject() < y.getObject();
+    });
+    // start of each group of probes sharing the same subject and predicate
+    std::vector<size_t> groups;
+    for (size_t i = 0; i < order.size(); i++) {
+      if (i == 0 || probes[order[i]].getSubject() != probes[order[i - 1]].getSubject() ||
+          probes[order[i]].getPredicate() != probes[order[i - 1]].getPredicate()) {
+        groups.push_back(i);
+      }
+    }
+    groups.push_back(order.size());
+    parallelFor(groups.size() - 1, resolveThreads(threads), [&](size_t begin, size_t end) {
+      for (size_t g = begin; g < end; g++) {
+        probeGroup(probes, order, groups[g], groups[g + 1], results);
+      }
+    });
+  }
+  return toBoolArray(std::move(results));
+}
+
+/*!
+ * Check the existence of a group of triple patterns sharing the same subject
+ * and predicate. When the adjacency list of the subject and predicate is
+ * short enough, it is read once and merged with the sorted objects of the
+ * probes, instead of searching each probe.
+ * @param probes  Triple patterns made of IDs
+ * @param order   Indexes of the probes, sorted by subject, predicate and object
+ * @param first   Position in order of the first probe of the group
+ * @param last    Position in order following the last probe of the group
+ * @param results Output: 1 for the probes which match a triple, 0 otherwise
+ */
+void HDTDocument::probeGroup(std::vector<TripleID> &probes, std::vector<size_t> &order,
+                             size_t first, size_t last, std::vector<uint8_t> &results) {
+  Triples *triples = hdt->getTriples();
+  Dictionary *dict = hdt->getDictionary();
+  TripleID &head = probes[order[first]];
+  // IDs out of the dictionary cannot match anything
+  if (head.getSubject() > dict->getMaxSubjectID() || head.getPredicate() > dict->getNpredicates()) {
+    return;
+  }
+  // objects are sorted, so they are all bound if the first one is
+  if (last - first > 1 && head.getSubject() != 0 && head.getPredicate() != 0 &&
+      head.getObject() != 0 && triples->getOrder() == SPO) {
+    TripleID pattern(head.getSubject(), head.getPredicate(), 0);
+    IteratorTripleID *it = triples->search(pattern);
+    if (it->estimatedNumResults() <= CONTAINS_SCAN_FACTOR * (last - first)) {
+      size_t current = 0;
+      for (size_t i = first; i < last; i++) {
+        size_t object = probes[order[i]].getObject();
+        while (current < object && it->hasNext()) {
+          current = it->next()->getObject();
+        }
+        results[order[i]] = current == object;
+      }
+      delete it;
+      return;
+    }
+    delete it;
+  }
+  for (size_t i = first; i < last; i++) {
+    TripleID &probe = probes[order[i]];
+    if (probe.getObject() > dict->getMaxObjectID()) {
+      continue;
+    }
+    IteratorTripleID *it = triples->search(probe);
+    results[order[i]] = it->hasNext();
+    delete it;
+  }
+}
+
+/*!
+ * Get the number of outgoing edges of an array of nodes
+ * @param ids       Global IDs of the nodes
+ * @param predicate Only count edges with this predicate, or 0 for all edges
+ * @param cache     If True, read the degrees from a table of the degrees of all nodes
+ * @param threads   Number of threads, 0 to use all hardware threads
+ * @param cachePath If not empty, store the cached degrees in this file, shared between processes
+ */
+py::array_t<unsigned int> HDTDocument::outDegree(py::array_t<unsigned int> ids, unsigned int predicate,
+                                                 bool cache, int threads, std::string cachePath) {
+  return degrees(ids, predicate, cache, threads, cachePath, true);
+}
+
+/*!
+ * Get the number of incoming edges of an array of nodes
+ * @param ids       Global IDs of the nodes
+ * @param predicate Only count edges with this predicate, or 0 for all edges
+ * @param cache     If True, read the degrees from a table of the degrees of all nodes
+ * @param threads   Number of threads, 0 to use all hardware threads
+ * @param cachePath If not empty, store the cached degrees in this file, shared between processes
+ */
+py::array_t<unsigned int> HDTDocument::inDegree(py::array_t<unsigned int> ids, unsigned int predicate,
+                                                bool cache, int threads, std::string cachePath) {
+  return degrees(ids, predicate, cache, threads, cachePath, false);
+}
+
+/*!
+ * Compute the out-degrees or in-degrees of an array of nodes. Per-predicate
+ * degrees are never cached, as there would be one table per predicate.
+ * @param ids       Global IDs of the nodes
+ * @param predicate Only count edges with this predicate, or 0 for all edges
+ * @param cache     If True, read the degrees from a table of the degrees of all nodes
+ * @param threads   Number of threads, 0 to use all hardware threads
+ * @param cachePath If not empty, store the cached degrees in this file, shared between processes
+ * @param outgoing  True for out-degrees, False for in-degrees
+ */
+py::array_t<unsigned int> HDTDocument::degrees(py::array_t<unsigned int> ids, unsigned int predicate,
+                                               bool cache, int threads, std::string cachePath,
+                                               bool outgoing) {
+  std::vector<unsigned int> nodes = toVector(ids, "Node IDs");
+  std::vector<unsigned int> results(nodes.size(), 0);
+  GraphView graph(hdt);
+  bool useCache = cache && predicate == 0;
+  std::shared_ptr<DegreeTable> table = degreeCache;
+  {
+    py::gil_scoped_release release;
+    if (useCache && !table && !cachePath.empty()) {
+      table = graph.sharedDegrees(cachePath, hdt_file);
+    } else if (useCache && !table) {
+      table = std::make_shared<DegreeTable>();
+      graph.allDegrees(*table);
+    }
+    if (useCache) {
+      const unsigned int *all = outgoing ? table->outDegrees : table->inDegrees;
+      for (size_t i = 0; i < nodes.size(); i++) {
+        results[i] = (nodes[i] < table->size) ? all[nodes[i]] : 0;
+      }
+    } else {
+      parallelFor(nodes.size(), resolveThreads(threads), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          results[i] = outgoing ? graph.outDegree(nodes[i], predicate)
+                                : graph.inDegree(nodes[i], predicate);
+        }
+      });
+    }
+  }
+  if (useCache) {
+    degreeCache = table;
+  }
+  return toArray(std::move(results));
+}
+
+/*!
+ * Get the adjacency lists of an array of nodes. Nodes are split into blocks,
+ * whose adjacency lists are read in parallel, then concatenated.
+ * @param ids        Global IDs of the nodes
+ * @param direction  Direction of the edges to follow: "out", "in" or "both"
+ * @param predicates Predicates of the edges to follow, or empty to follow all edges
+ * @param threads    Number of threads, 0 to use all hardware threads
+ */
+csr_adjacency HDTDocument::neighbors(py::array_t<unsigned int> ids, std::string direction,
+                                     std::vector<unsigned int> predicates, int threads) {
+  std::vector<unsigned int> nodes = toVector(ids, "Node IDs");
+  EdgeDirection edgeDirection = parseDirection(direction);
+  normalizePredicates(predicates);
+
+  std::vector<uint64_t> indptr(nodes.size() + 1, 0);
+  std::vector<unsigned int> neighborIDs;
+  std::vector<unsigned int> labels;
+  {
+    py::gil_scoped_release release;
+    GraphView graph(hdt);
+    size_t nbBlocks = std::min(nodes.size(), NEIGHBORS_BLOCKS_PER_THREAD * resolveThreads(threads));
+    std::vector<std::vector<unsigned int>> blockNeighbors(nbBlocks), blockLabels(nbBlocks);
+    parallelFor(nbBlocks, resolveThreads(threads), [&](size_t begin, size_t end) {
+      for (size_t b = begin; b < end; b++) {
+        size_t first = (nodes.size() * b) / nbBlocks, last = (nodes.size() * (b + 1)) / nbBlocks;
+        for (size_t i = first; i < last; i++) {
+          graph.neighbors(nodes[i], edgeDirection, predicates, blockNeighbors[b], blockLabels[b]);
+          indptr[i + 1] = blockNeighbors[b].size();
+        }
+      }
+    });
+    // offsets are relative to their block, until blocks are concatenated
+    for (size_t b = 0; b < nbBlocks; b++) {
+      size_t first = (nodes.size() * b) / nbBlocks, last = (nodes.size() * (b + 1)) / nbBlocks;
+      uint64_t base = neighborIDs.size();
+      for (size_t i = first; i < last; i++) {
+        indptr[i + 1] += base;
+      }
+      neighborIDs.insert(neighborIDs.end(), blockNeighbors[b].begin(), blockNeighbors[b].end());
+      labels.insert(labels.end(), blockLabels[b].begin(), blockLabels[b].end());
+      std::vector<unsigned int>().swap(blockNeighbors[b]);
+      std::vector<unsigned int>().swap(blockLabels[b]);
+    }
+  }
+  return std::make_tuple(toArray(std::move(indptr)), toArray(std::move(neighborIDs)),
+                         toArray(std::move(labels)));
+}
+
+/*!
+ * Draw triples uniformly at random among the triples matching a triple pattern.
+ * Random positions are drawn first, then sorted so that each thread reads its
+ * triples in order. Triples are read by jumping to their position when the
+ * iterator supports it and knows the exact number of matches. Otherwise, a
+ * first scan counts the matching triples, and a second scan, on a single
+ * thread, reads the triples at the drawn positions.
+ * @param n       Number of triples to draw
+ * @param pattern Triple pattern (subject, predicate, object) made of IDs, or None for all triples
+ * @param seed    Seed of the random generator, or a negative value for a random seed
+ * @param threads Number of threads, 0 to use all hardware threads
+ */
+py::array_t<unsigned int> HDTDocument::sampleTriples(size_t n, py::object pattern,
+                                                     long long seed, int threads) {
+  std::tuple<unsigned int, unsigned int, unsigned int> ids(0, 0, 0);
+  if (!pattern.is_none()) {
+    ids = pattern.cast<std::tuple<unsigned int, unsigned int, unsigned int>>();
+  }
+  std::vector<unsigned int> results;
+  {
+    py::gil_scoped_release release;
+    TripleID tp(std::get<0>(ids), std::get<1>(ids), std::get<2>(ids));
+    Dictionary *dict = hdt->getDictionary();
+    size_t nbMatches = 0;
+    bool positional = false;
+    // IDs out of the dictionary cannot match anything
+    if (tp.getSubject() <= dict->getMaxSubjectID() && tp.getPredicate() <= dict->getNpredicates() &&
+        tp.getObject() <= dict->getMaxObjectID()) {
+      IteratorTripleID *it = hdt->getTriples()->search(tp);
+      positional = it->canGoTo() && it->numResultEstimation() == EXACT;
+      nbMatches = it->estimatedNumResults();
+      if (!positional) {
+        // count the matching triples with a first scan
+        nbMatches = 0;
+        while (it->hasNext()) {
+          it->next();
+          nbMatches++;
+        }
+      }
+      delete it;
+    }
+    if (nbMatches == 0 && n > 0) {
+      throw std::runtime_error("No RDF triple matches the triple pattern");
+    }
+
+    std::mt19937_64 generator((seed < 0) ? std::random_device()() : (unsigned long long) seed);
+    std::uniform_int_distribution<size_t> distribution(0, (nbMatches > 0) ? nbMatches - 1 : 0);
+    std::vector<std::pair<size_t, size_t>> draws(n);
+    for (size_t i = 0; i < n; i++) {
+      draws[i] = std::make_pair(distribution(generator), i);
+    }
+    std::sort(draws.begin(), draws.end());
+    results.assign(3 * n, 0);
+    parallelFor(n, positional ? resolveThreads(threads) : 1, [&](size_t begin, size_t end) {
+      readPositions(tp, draws, begin, end, positional, results);
+    });
+  }
+  return toArray(std::move(results), 3);
+}
+
+/*!
+ * Read the triples at sorted positions of the triples matching a triple pattern
+ * @param pattern    Triple pattern made of IDs
+ * @param draws      Pairs (position, index), sorted by position
+ * @param begin      First draw read
+ * @param end        Draw following the last draw read
+ * @param positional If True, jump to positions, otherwise read all triples up to them
+ * @param results    Output: 3 IDs per draw, at the index of the draw
+ */
+void HDTDocument::readPositions(TripleID pattern, std::vector<std::pair<size_t, size_t>> &draws,
+                                size_t begin, size_t end, bool positional,
+                                std::vector<unsigned int> &results) {
+  IteratorTripleID *it = hdt->getTriples()->search(pattern);
+  // position of the next triple returned by the iterator
+  size_t current = 0;
+  TripleID triple;
+  for (size_t i = begin; i < end; i++) {
+    size_t position = draws[i].first;
+    // the same position may be drawn several times
+    if (i == begin || position != draws[i - 1].first) {
+      if (position != current && positional) {
+        it->goTo(position);
+      }
+      for (; position > current && !positional; current++) {
+        it->next();
+      }
+      triple = *it->next();
+      current = position + 1;
+    }
+    size_t index = draws[i].second;
+    results[3 * index] = triple.getSubject();
+    results[3 * index + 1] = triple.getPredicate();
+    results[3 * index + 2] = triple.getObject();
+  }
+  delete it;
+}
+
+/*!
+ * Check the parameters of random walks
+ * @param  length     Number of nodes of each walk, including its start node
+ * @param  direction  Direction of the edges to follow: "out", "in" or "both"
+ * @param  predicates Predicates of the edges to follow, or empty to follow all edges
+ * @param  p          Node2vec return parameter
+ * @param  q          Node2vec in-out parameter
+ * @return            Options of the walks
+ */
+static WalkOptions walkOptions(size_t length, std::string direction,
+                               std::vector<unsigned int> predicates, double p, double q) {
+  if (length == 0) {
+    throw std::runtime_error("The length of random walks must be at least 1");
+  }
+  if (!(p > 0) || !(q > 0)) {
+    throw std::runtime_error("Node2vec parameters p and q must be strictly positive");
+  }
+  WalkOptions options;
+  options.length = length;
+  options.direction = parseDirection(direction);
+  options.predicates = predicates;
+  normalizePredicates(options.predicates);
+  options.p = p;
+  options.q = q;
+  return options;
+}
+
+/*!
+ * Get the base seed of random walks
+ * @param  seed Seed given by the user, or a negative value for a random seed
+ * @return      Base seed of the walks
+ */
+static uint64_t baseSeed(long long seed) {
+  if (seed >= 0) {
+    return seed;
+  }
+  std::random_device device;
+  return ((uint64_t) device() << 32) | device();
+}
+
+/*!
+ * Perform random walks from an array of start nodes
+ * @param ids          Global IDs of the start nodes
+ * @param walksPerNode Number of walks from each start node
+ * @param length       Number of nodes of each walk, including its start node
+ * @param direction    Direction of the edges to follow: "out", "in" or "both"
+ * @param predicates   Predicates of the edges to follow, or empty to follow all edges
+ * @param p            Node2vec return parameter
+ * @param q            Node2vec in-out parameter
+ * @param seed         Seed of the random generators, or a negative value for a random seed
+ * @param threads      Number of threads, 0 to use all hardware threads
+ */
+py::array_t<unsigned int> HDTDocument::randomWalks(py::array_t<unsigned int> ids, size_t walksPerNode,
+                                                   size_t length, std::string direction,
+                                                   std::vector<unsigned int> predicates,
+                                                   double p, double q, long long seed, int threads) {
+  std::vector<unsigned int> nodes = toVector(ids, "Node IDs");
+  WalkOptions options = walkOptions(length, direction, predicates, p, q);
+  size_t nbWalks = nodes.size() * walksPerNode;
+  // walks are written in place, in an array allocated once
+  std::vector<unsigned int> walks(nbWalks * length, 0);
+  {
+    py::gil_scoped_release release;
+    std::vector<size_t> sizes;
+    runWalks(nodes, 0, nbWalks, options, baseSeed(seed), threads, walks, sizes);
+  }
+  return toArray(std::move(walks), length);
+}
+
+/*!
+ * Perform random walks from an array of start nodes, and write them in a text file.
+ * Walks are computed by batches, so memory usage does not depend on the number of walks.
+ * @param path         Path of the text file
+ * @param ids          Global IDs of the start nodes
+ * @param walksPerNode Number of walks from each start node
+ * @param length       Number of nodes of each walk, including its start node
+ * @param direction    Direction of the edges to follow: "out", "in" or "both"
+ * @param predicates   Predicates of the edges to follow, or empty to follow all edges
+ * @param p            Node2vec return parameter
+ * @param q            Node2vec in-out parameter
+ * @param seed         Seed of the random generators, or a negative value for a random seed
+ * @param threads      Number of threads, 0 to use all hardware threads
+ */
+size_t HDTDocument::writeRandomWalks(std::string path, py::array_t<unsigned int> ids,
+                                     size_t walksPerNode, size_t length, std::string direction,
+                                     std::vector<unsigned int> predicates, double p, double q,
+                                     long long seed, int threads) {
+  std::vector<unsigned int> nodes = toVector(ids, "Node IDs");
+  WalkOptions options = walkOptions(length, direction, predicates, p, q);
+  size_t nbWalks = nodes.size() * walksPerNode;
+  std::ofstream output(path.c_str());
+  if (!output.is_open()) {
+    throw std::runtime_error("Cannot open file '" + path + "'");
+  }
+  {
+    py::gil_scoped_release release;
+    uint64_t base = baseSeed(seed);
+    std::vector<unsigned int> walks;
+    std::vector<size_t> sizes;
+    for (size_t first = 0; first < nbWalks; first += RANDOM_WALKS_BATCH_SIZE) {
+      size_t last = std::min(nbWalks, first + RANDOM_WALKS_BATCH_SIZE);
+      walks.assign((last - first) * length, 0);
+      runWalks(nodes, first, last, options, base, threads, walks, sizes);
+      for (size_t i = 0; i < last - first; i++) {
+        for (size_t j = 0; j < sizes[i]; j++) {
+          output << ((j > 0) ? " " : "") << walks[i * length + j];
+        }
+        output << '\n';
+      }
+    }
+    output.close();
+  }
+  if (output.fail()) {
+    throw std::runtime_error("Cannot write random walks to file '" + path + "'");
+  }
+  return nbWalks;
+}
+
+/*!
+ * Perform the random walks [first, last) in parallel
+ * @param nodes   Start nodes
+ * @param first   Index of the first walk
+ * @param last    Index following the last walk
+ * @param options Length, direction, predicates and node2vec parameters of the walks
+ * @param seed    Base seed: walk i uses a generator seeded from seed and i
+ * @param threads Number of threads, 0 to use all hardware threads
+ * @param walks   Output: walks, padded with 0, with room for (last - first) * options.length nodes
+ * @param sizes   Output: number of nodes of each walk
+ */
+void HDTDocument::runWalks(std::vector<unsigned int> &nodes, size_t first, size_t last,
+                           WalkOptions &options, uint64_t seed, int threads,
+                           std::vector<unsigned int> &walks, std::vector<size_t> &sizes) {
+  GraphView graph(hdt);
+  sizes.assign(last - first, 0);
+  parallelFor(last - first, resolveThreads(threads), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      size_t walk = first + i;
+      // each walk draws from its own generator, seeded from its index
+      uint64_t walkSeed = SplitMix64(seed + walk).next();
+      sizes[i] = graph.randomWalk(nodes[walk % nodes.size()], options, walkSeed,
+                                  &walks[i * options.length]);
+    }
+  });
+}
+
+/*!
+ * Draw corrupted triples. Each triple draws from its own random generator,
+ * seeded from its index, so results do not depend on the number of threads.
+ * @param positives Array of shape (n, 3) of triples made of IDs
+ * @param k         Number of corrupted triples per triple
+ * @param mode      "head" to replace subjects, "tail" to replace objects
+ * @param filtered  If True, only keep corrupted triples absent from the HDT document
+ * @param seed      Seed of the random generator, or a negative value for a random seed
+ * @param threads   Number of threads, 0 to use all hardware threads
+ */
+py::array_t<unsigned int> HDTDocument::negativeSamples(py::array_t<unsigned int> positives, size_t k,
+                                                       std::string mode, bool filtered,
+                                                       long long seed, int threads) {
+  if (positives.ndim() != 2 || positives.shape(1) != 3) {
+    throw std::runtime_error("Triples must be an array of shape (n, 3)");
+  }
+  if (mode != "head" && mode != "tail") {
+    throw std::runtime_error("Unknown mode '" + mode + "', expected 'head' or 'tail'");
+  }
+  bool head = mode == "head";
+  auto view = positives.unchecked<2>();
+  Dictionary *dict = hdt->getDictionary();
+  std::vector<TripleID> triples;
+  for (py::ssize_t i = 0; i < positives.shape(0); i++) {
+    if (view(i, 0) == 0 || view(i, 1) == 0 || view(i, 2) == 0 ||
+        view(i, 0) > dict->getMaxSubjectID() || view(i, 1) > dict->getNpredicates() ||
+        view(i, 2) > dict->getMaxObjectID()) {
+      throw std::runtime_error("Triple " + std::to_string(i) + " is not a triple of IDs of the HDT dictionary");
+    }
+    triples.push_back(TripleID(view(i, 0), view(i, 1), view(i, 2)));
+  }
+  std::vector<unsigned int> results(triples.size() * k * 3, 0);
+  {
+    py::gil_scoped_release release;
+    Triples *hdtTriples = hdt->getTriples();
+    // subjects are the shared and subject sections, objects the shared and object sections
+    size_t nbCandidates = head ? dict->getMaxSubjectID() : dict->getMaxObjectID();
+    uint64_t base = baseSeed(seed);
+    parallelFor(triples.size(), resolveThreads(threads), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        SplitMix64 generator(SplitMix64(base + i).next());
+        for (size_t j = 0; j < k; j++) {
+          TripleID corrupted = triples[i];
+          bool found = false;
+          for (size_t attempt = 0; attempt < NEGATIVE_SAMPLES_MAX_ATTEMPTS && !found; attempt++) {
+            size_t entity = 1 + generator.below(nbCandidates);
+            if (head) {
+              corrupted.setSubject(entity);
+            } else {
+              corrupted.setObject(entity);
+            }
+            found = true;
+            if (filtered) {
+              IteratorTripleID *it = hdtTriples->search(corrupted);
+              found = !it->hasNext();
+              delete it;
+            }
+          }
+          if (!found) {
+            throw std::runtime_error("No negative sample of triple " + std::to_string(i) + " found after " +
+                                     std::to_string(NEGATIVE_SAMPLES_MAX_ATTEMPTS) + " draws");
+          }
+          size_t row = 3 * (i * k + j);
+          results[row] = corrupted.getSubject();
+          results[row + 1] = corrupted.getPredicate();
+          results[row + 2] = corrupted.getObject();
+        }
+      }
+    });
+  }
+  return toArray(std::move(results), 3);
+}
+
+/*!
+ * Sample multi-layer neighborhoods of a batch of seed nodes. Nodes of a layer
+ * are sampled in parallel, each one with its own random generator, then the
+ * sampled neighbors are mapped to local IDs.
+ * @param ids        Global IDs of the seed nodes
+ * @param fanouts    Maximum number of neighbors sampled per node, for each layer
+ * @param direction  Direction of the edges to follow: "out", "in" or "both"
+ * @param predicates Predicates of the edges to follow, or empty to follow all edges
+ * @param seed       Seed of the random generators, or a negative value for a random seed
+ * @param threads    Number of threads, 0 to use all hardware threads
+ */
+sampled_neighborhood HDTDocument::sampleNeighborhood(py::array_t<unsigned int> ids, std::vector<size_t> fanouts,
+                                                     std::string direction, std::vector<unsigned int> predicates,
+                                                     long long seed, int threads) {
+  std::vector<unsigned int> seeds = toVector(ids, "Node IDs");
+  EdgeDirection edgeDirection = parseDirection(direction);
+  normalizePredicates(predicates);
+  std::vector<std::vector<unsigned int>> layerNodes(1, seeds);
+  std::vector<std::vector<unsigned int>> src(fanouts.size()), dst(fanouts.size()), labels(fanouts.size());
+  {
+    py::gil_scoped_release release;
+    GraphView graph(hdt);
+    uint64_t base = baseSeed(seed);
+    // local IDs of the nodes found so far
+    std::unordered_map<unsigned int, unsigned int> localIDs;
+    for (size_t i = 0; i < seeds.size(); i++) {
+      if (localIDs.find(seeds[i]) == localIDs.end()) {
+        localIDs[seeds[i]] = i;
+      }
+    }
+    for (size_t layer = 0; layer < fanouts.size(); layer++) {
+      std::vector<unsigned int> &targets = layerNodes[layer];
+      size_t fanout = fanouts[layer];
+      std::vector<unsigned int> sampled(targets.size() * fanout), sampledLabels(targets.size() * fanout);
+      std::vector<size_t> counts(targets.size(), 0);
+      parallelFor(targets.size(), resolveThreads(threads), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          SplitMix64 generator(SplitMix64(base + layer * 0x9e3779b97f4a7c15ULL + i).next());
+          counts[i] = graph.sampleNeighbors(targets[i], edgeDirection, predicates, fanout, generator,
+                                            &sampled[i * fanout], &sampledLabels[i * fanout]);
+        }
+      });
+      // the nodes of the next layer start with the nodes of this layer
+      std::vector<unsigned int> next(targets);
+      for (size_t i = 0; i < targets.size(); i++) {
+        for (size_t j = i * fanout; j < i * fanout + counts[i]; j++) {
+          auto found = localIDs.find(sampled[j]);
+          if (found == localIDs.end()) {
+            found = localIDs.insert(std::make_pair(sampled[j], (unsigned int) next.size())).first;
+            next.push_back(sampled[j]);
+          }
+          src[layer].push_back(found->second);
+          dst[layer].push_back(localIDs[targets[i]]);
+          labels[layer].push_back(sampledLabels[j]);
+        }
+      }
+      layerNodes.push_back(next);
+    }
+  }
+  std::vector<py::array_t<unsigned int>> nodes;
+  for (size_t i = 0; i < layerNodes.size(); i++) {
+    nodes.push_back(toArray(std::move(layerNodes[i])));
+  }
+  std::vector<std::tuple<py::array_t<unsigned int>, py::array_t<unsigned int>, py::array_t<unsigned int>>> blocks;
+  for (size_t i = 0; i < fanouts.size(); i++) {
+    blocks.push_back(std::make_tuple(toArray(std::move(src[i])), toArray(std::move(dst[i])),
+                                     toArray(std::move(labels[i]))));
+  }
+  return std::make_tuple(nodes, blocks);
+}
+
+/*!
+ * Get the IDs of type predicates, skipping the predicates missing from the dictionary
+ * @param  dict       Dictionary of the HDT document
+ * @param  predicates Type predicates
+ * @return            Sorted IDs of the predicates
+ */
+static std::vector<size_t> typePredicateIDs(Dictionary *dict, std::vector<std::string> &predicates) {
+  std::vector<size_t> ids;
+  for (size_t i = 0; i < predicates.size(); i++) {
+    size_t id = dict->stringToId(predicates[i], PREDICATE);
+    if (id > 0) {
+      ids.push_back(id);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return ids;
+}
+
+bool HDTDocument::loadTypeIndex(std::vector<std::string> predicates, std::string path, int threads) {
+  std::vector<size_t> predicateIDs;
+  {
+    std::lock_guard<std::mutex> lock(*decodeMutex);
+    predicateIDs = typePredicateIDs(hdt->getDictionary(), predicates);
+  }
+  if (path.empty()) {
+    path = hdt_file + ".types";
+  }
+  py::gil_scoped_release release;
+  std::shared_ptr<TypeIndex> index;
+  try {
+    index = std::make_shared<TypeIndex>(path);
+  } catch (const std::runtime_error &) {
+    // missing or invalid index file, rebuilt below
+  }
+  bool built = false;
+  if (!index || !index->isValidFor(hdt, hdt_file, predicateIDs)) {
+    TypeIndex::build(hdt, hdt_file, predicateIDs, path, resolveThreads(threads));
+    index = std::make_shared<TypeIndex>(path);
+    built = true;
+  }
+  typeIndex = index;
+  return built;
+}
+
+csr_types HDTDocument::typesOf(py::array_t<unsigned int> ids) {
+  std::vector<unsigned int> entities = toVector(ids, "ids");
+  GlobalIDMapping mapping(hdt->getDictionary());
+  std::vector<uint64_t> indptr(1, 0);
+  std::vector<unsigned int> types;
+  {
+    py::gil_scoped_release release;
+    size_t typeID;
+    {
+      std::lock_guard<std::mutex> lock(*decodeMutex);
+      typeID = hdt->getDictionary()->stringToId(typeString, PREDICATE);
+    }
+    for (size_t i = 0; i < entities.size(); i++) {
+      size_t subject = mapping.fromGlobal(entities[i], SUBJECT);
+      size_t first = types.size();
+      if (typeIndex) {
+        const uint32_t *begin, *end;
+        typeIndex->getTypes(subject, begin, end);
+        types.insert(types.end(), begin, end);
+      } else if (subject > 0 && typeID > 0) {
+        TripleID pattern(subject, typeID, 0);
+        IteratorTripleID *it = hdt->getTriples()->search(pattern);
+        while (it->hasNext()) {
+          types.push_back(it->next()->getObject());
+        }
+        delete it;
+        std::sort(types.begin() + first, types.end());
+      }
+      for (size_t j = first; j < types.size(); j++) {
+        types[j] = mapping.toGlobal(types[j], OBJECT);
+      }
+      indptr.push_back(types.size());
+    }
+  }
+  return std::make_tuple(toArray(std::move(indptr)), toArray(std::move(types)));
+}
+
+py::tuple HDTDocument::getState() {
+  std::vector<unsigned int> predicates(preds.begin(), preds.end());
+  std::sort(predicates.begin(), predicates.end());
+  size_t hopCacheCapacity = hopCache ? hopCache->getStats()["capacity"] : 0;
+  std::string typeIndexPath = typeIndex ? typeIndex->getPath() : "";
+  std::vector<unsigned int> prefixBounds = {preffixIniSO,      preffixEndSO,     preffixIniSUBJECT,
+                                            preffixEndSUBJECT, preffixIniOBJECT, preffixEndOBJECT};
+  return py::make_tuple(hdt_file, numHops, predicates, filterPrefixStr, continuousDictionary,
+                        includeLiterals, maxOutDegree, maxInDegree, truncateHubs,
+                        hopCacheCapacity, typeIndexPath, literalEndID, prefixBounds,
+                        hashJoinMinCardinality, parallelMinCardinality);
+}
+
+HDTDocument HDTDocument::fromState(py::tuple state) {
+  if (state.size() != 15) {
+    throw std::runtime_error("Invalid state of a HDTDocument");
+  }
+  HDTDocument doc(state[0].cast<std::string>());
+  // the hop configuration is restored as is, as computing its ID ranges scans the dictionary
+  doc.numHops = state[1].cast<int>();
+  std::vector<unsigned int> filterPredicates = state[2].cast<std::vector<unsigned int>>();
+  doc.preds.insert(filterPredicates.begin(), filterPredicates.end());
+  doc.filterPrefixStr = state[3].cast<std::string>();
+  doc.continuousDictionary = state[4].cast<bool>();
+  doc.includeLiterals = state[5].cast<bool>();
+  doc.maxOutDegree = state[6].cast<size_t>();
+  doc.maxInDegree = state[7].cast<size_t>();
+  doc.truncateHubs = state[8].cast<bool>();
+  doc.updateHopFilters();
+  doc.literalEndID = state[11].cast<unsigned int>();
+  std::vector<unsigned int> prefixBounds = state[12].cast<std::vector<unsigned int>>();
+  if (prefixBounds.size() != 6) {
+    throw std::runtime_error("Invalid state of a HDTDocument");
+  }
+  doc.preffixIniSO = prefixBounds[0];
+  doc.preffixEndSO = prefixBounds[1];
+  doc.preffixIniSUBJECT = prefixBounds[2];
+  doc.preffixEndSUBJECT = prefixBounds[3];
+  doc.preffixIniOBJECT = prefixBounds[4];
+  doc.preffixEndOBJECT = prefixBounds[5];
+  doc.configureJoins(state[13].cast<size_t>(), state[14].cast<size_t>());
+  doc.configureHopCache(state[9].cast<size_t>());
+  std::string typeIndexPath = state[10].cast<std::string>();
+  if (!typeIndexPath.empty()) {
+    // the index file is mapped once per process, whatever the number of documents using it
+    std::shared_ptr<TypeIndex> index = std::make_shared<TypeIndex>(typeIndexPath);
+    std::vector<size_t> predicates = index->getPredicates();
+    if (!index->isValidFor(doc.hdt, doc.hdt_file, predicates)) {
+      throw std::runtime_error("The type index '" + typeIndexPath + "' was built for another HDT file");
+    }
+    doc.typeIndex = index;
+  }
+  return doc;
+}
+
 /*!
  * Get the total number of triples in the HDT document
  * @return [description]
@@ -192,13 +1212,38 @@ unsigned int HDTDocument::getNbShared() {
  */
 triple HDTDocument::idsToString(unsigned int subject, unsigned int predicate,
                                 unsigned int object) {
+  std::lock_guard<std::mutex> lock(*decodeMutex);
   return std::make_tuple(
       hdt->getDictionary()->idToString(subject, hdt::SUBJECT),
       hdt->getDictionary()->idToString(predicate, hdt::PREDICATE),
       hdt->getDictionary()->idToString(object, hdt::OBJECT));
 }
 
-JoinIterator * HDTDocument::searchJoin(std::vector<triple> patterns) {
+/*!
+ * Evaluate a join between triple patterns.
+ * The pyHDT join planner is used for star joins, and when it selects hash joins
+ * or parallel execution, to evaluate a limit/offset without materializing
+ * intermediate results, and to evaluate filters on IDs during scans.
+ * Otherwise, the join is evaluated by the HDT QueryProcessor.
+ * @param patterns     Triple patterns of the join
+ * @param memoryBudget Memory budget of each hash join, in bytes, or of all hash joins with threads > 1
+ * @param threads      Number of worker threads, 0 to use all hardware threads
+ * @param limit        Maximum number of solutions to produce, 0 for no limit
+ * @param offset       Number of solutions to skip
+ * @param filters      Filters on the join variables
+ */
+JoinIterator * HDTDocument::searchJoin(std::vector<triple> patterns, size_t memoryBudget, int threads, size_t limit, size_t offset, std::vector<filter_expr> filters) {
+  std::unique_lock<std::mutex> lock(*decodeMutex);
+  JoinPlanner planner(hdt, patterns, filters);
+  lock.unlock();
+  planner.setHashJoinMinCardinality(hashJoinMinCardinality);
+  planner.setParallelMinCardinality(parallelMinCardinality);
+  BindingOperator *pipeline = planner.plan(memoryBudget, threads, limit, offset);
+  if (pipeline != NULL) {
+    return new JoinIterator(pipeline, planner.getVarNames(), planner.getVarRoles(),
+                            hdt->getDictionary(), planner.getMapping(), decodeMutex);
+  }
+
   set<string> vars {};
   vector<TripleString> joinPatterns {};
   std::string subj, pred, obj;
@@ -221,50 +1266,108 @@ JoinIterator * HDTDocument::searchJoin(std::vector<triple> patterns) {
     joinPatterns.push_back(pattern);
   }
 
+  lock.lock();
   VarBindingString *iterator = processor->searchJoin(joinPatterns, vars);
-  return new JoinIterator(iterator);
+  lock.unlock();
+  return new JoinIterator(iterator, decodeMutex, limit, offset, planner.getFilters());
+}
+
+void HDTDocument::configureJoins(size_t setHashJoinMinCardinality, size_t setParallelMinCardinality) {
+  hashJoinMinCardinality = setHashJoinMinCardinality;
+  parallelMinCardinality = setParallelMinCardinality;
 }
 
 string HDTDocument::idToString (unsigned int id, hdt::TripleComponentRole role){
+	std::lock_guard<std::mutex> lock(*decodeMutex);
 	return hdt->getDictionary()->idToString(id,role);
 }
 
 unsigned int HDTDocument::StringToid (string term, hdt::TripleComponentRole role){
+	std::lock_guard<std::mutex> lock(*decodeMutex);
 	return hdt->getDictionary()->stringToId(term,role);
 }
 
 string HDTDocument::globalIdToString (unsigned int id, hdt::TripleComponentRole role){
-	if (role==OBJECT){
-		if (continuousDictionary && id>hdt->getDictionary()->getNsubjects()){
-			// convert the id to the traditional one
-			id = id - (hdt->getDictionary()->getNsubjects()-hdt->getDictionary()->getNshared());
-		}
+	if (role==OBJECT && continuousDictionary){
+		// convert the id to the traditional one
+		GlobalIDMapping mapping(hdt->getDictionary());
+		id = mapping.fromGlobal(id,mapping.decodingRole(id));
 	}
 
+	std::lock_guard<std::mutex> lock(*decodeMutex);
 	return hdt->getDictionary()->idToString(id,role);
 
 }
 
 unsigned int HDTDocument::StringToGlobalId (string term, hdt::TripleComponentRole role){
+	std::unique_lock<std::mutex> lock(*decodeMutex);
 	unsigned int id = hdt->getDictionary()->stringToId(term,role);
-		if (role==OBJECT){
-			if (continuousDictionary && id>hdt->getDictionary()->getNsubjects()){
-				id=id+(hdt->getDictionary()->getNsubjects()-hdt->getDictionary()->getNshared());
-			}
-		}
-		return id;
+	lock.unlock();
+	if (continuousDictionary){
+		id = GlobalIDMapping(hdt->getDictionary()).toGlobal(id,role);
+	}
+	return id;
+}
+
+py::array_t<unsigned int> HDTDocument::toGlobalIDs(py::array_t<unsigned int> ids, hdt::TripleComponentRole role){
+	std::vector<unsigned int> values = toVector(ids, "ids");
+	{
+		py::gil_scoped_release release;
+		GlobalIDMapping(hdt->getDictionary()).toGlobal(values.data(),values.size(),role,values.data());
+	}
+	return toArray(std::move(values));
+}
+
+std::tuple<py::array_t<unsigned int>, py::array_t<uint8_t>> HDTDocument::fromGlobalIDs(py::array_t<unsigned int> ids){
+	std::vector<unsigned int> values = toVector(ids, "ids");
+	std::vector<uint8_t> roles(values.size());
+	{
+		py::gil_scoped_release release;
+		GlobalIDMapping(hdt->getDictionary()).fromGlobal(values.data(),values.size(),values.data(),roles.data());
+	}
+	return std::make_tuple(toArray(std::move(values)), toArray(std::move(roles)));
+}
+
+void HDTDocument::updateHopFilters(){
+	// filters and their hash, to only reuse cached neighbourhoods computed with the same filters
+	std::shared_ptr<HopFilters> filters = std::make_shared<HopFilters>();
+	filters->predicates.assign(preds.begin(), preds.end());
+	std::sort(filters->predicates.begin(), filters->predicates.end());
+	filters->prefix = filterPrefixStr;
+	filters->includeLiterals = includeLiterals;
+	filters->maxOutDegree = maxOutDegree;
+	filters->maxInDegree = maxInDegree;
+	filters->truncateHubs = truncateHubs;
+	hopFilters = filters;
+	std::vector<size_t> hashed(filters->predicates.begin(), filters->predicates.end());
+	hashed.push_back(maxOutDegree);
+	hashed.push_back(maxInDegree);
+	hashed.push_back(truncateHubs);
+	hopConfigHash = std::hash<std::string>()(filterPrefixStr) ^ (includeLiterals ? 0x9e3779b9 : 0);
+	for (size_t i=0;i<hashed.size();i++){
+		hopConfigHash ^= hashed[i] + 0x9e3779b9 + (hopConfigHash << 6) + (hopConfigHash >> 2);
+	}
 }
 
-void HDTDocument::configureHops(int setnumHops,vector<unsigned int> filterPredicates,string setfilterPrefixStr,bool setcontinuousDictionary, bool setincludeLiterals){
+void HDTDocument::configureHops(int setnumHops,vector<unsigned int> filterPredicates,string setfilterPrefixStr,bool setcontinuousDictionary, bool setincludeLiterals,
+		size_t setmaxOutDegree, size_t setmaxInDegree, bool settruncateHubs){
 	numHops = setnumHops;
 	preds.clear();
 	std::copy(filterPredicates.begin(),
 			filterPredicates.end(),
 	            std::inserter(preds, preds.end()));
 	continuousDictionary = setcontinuousDictionary;
+	includeLiterals = setincludeLiterals;
+	maxOutDegree = setmaxOutDegree;
+	maxInDegree = setmaxInDegree;
+	truncateHubs = settruncateHubs;
 
 	// Get range of preffix
 	filterPrefixStr = setfilterPrefixStr;
+	updateHopFilters();
+
+	// the scans below decode terms
+	std::lock_guard<std::mutex> lock(*decodeMutex);
 
 	// get the ID of literals if needed
 	if (setfilterPrefixStr=="" || (setfilterPrefixStr!="predef-dbpedia2016-04"&& setfilterPrefixStr!="predef-wikidata2020-03-all" && setfilterPrefixStr!="predef-wikidata2018-09-all")){
@@ -367,35 +1470,86 @@ vector<vector<unsigned int>> HDTDocument::filterTypeIDs(vector<unsigned int> ter
 	vector<unsigned int> classesCorrectId; //the provided classes with the correct IDs
 
 	//initialize map with the classes provided
-	for (int i=0;i<classes.size();i++){
-		vector<unsigned int> entities;
+	GlobalIDMapping mapping(hdt->getDictionary());
+	for (size_t i=0;i<classes.size();i++){
 		unsigned int classID=classes[i];
 		if (continuousDictionary){ //get the appropriate ID
-			if (classID>hdt->getDictionary()->getNsubjects()){
-				// convert the id to the traditional one
-				classID = classID - (hdt->getDictionary()->getNsubjects()-hdt->getDictionary()->getNshared());
-			}
+			classID = mapping.fromGlobal(classID,mapping.decodingRole(classID));
 		}
 		classesCorrectId.push_back(classID);
-		classesToEntities[classID]=entities;
+		classesToEntities[classID]=vector<unsigned int>();
 	}
 
 	// get the ID of the type
+	std::unique_lock<std::mutex> lock(*decodeMutex);
 	unsigned int typeID = hdt->getDictionary()->stringToId(typeString,PREDICATE);
-	for (int i=0;i<terms.size();i++){
-		unsigned int term =terms[i];
-		IteratorTripleID *it=NULL;
-		TripleID patternSubject(term,typeID,0);
-		it  = hdt->getTriples()->search(patternSubject);
-		while (it->hasNext())
-		{
-			unsigned int classValueID = it->next()->getObject();
-			if (classesToEntities.find(classValueID)!=classesToEntities.end()){ //if the class is one of the one we are interested, add the entity
-				classesToEntities[classValueID].push_back(term);
+	lock.unlock();
+
+	// sorted terms, with their position in the list of terms
+	vector<std::pair<unsigned int, size_t>> sortedTerms;
+	for (size_t i=0;i<terms.size();i++){
+		sortedTerms.push_back(std::make_pair(terms[i],i));
+	}
+	std::sort(sortedTerms.begin(),sortedTerms.end());
+
+	// pick a plan for each class: the entities of small classes, or of all classes when the type
+	// index is loaded, are merged with the sorted terms, while the terms of large classes are
+	// checked one by one
+	map<unsigned int, vector<unsigned int>> probedClasses;
+	for (auto iter = classesToEntities.begin(); iter != classesToEntities.end(); ++iter){
+		unsigned int classID = iter->first;
+		vector<unsigned int> subjects;
+		const uint32_t *first, *last;
+		if (typeIndex){
+			typeIndex->getEntities(classID,first,last);
+		}
+		else {
+			TripleID patternClass(0,typeID,classID);
+			IteratorTripleID *it = hdt->getTriples()->search(patternClass);
+			if (it->estimatedNumResults() > FILTER_TYPES_PROBE_COST*terms.size()){
+				probedClasses[classID]=vector<unsigned int>();
+				delete it;
+				continue;
+			}
+			while (it->hasNext()){
+				subjects.push_back(it->next()->getSubject());
+			}
+			delete it;
+			std::sort(subjects.begin(),subjects.end());
+			first = subjects.data();
+			last = first + subjects.size();
+		}
+		// merge join between the subjects of the class and the terms
+		vector<bool> found(terms.size(),false);
+		for (size_t i=0;i<sortedTerms.size();i++){
+			while (first<last && *first<sortedTerms[i].first){
+				first++;
 			}
+			found[sortedTerms[i].second] = first<last && *first==sortedTerms[i].first;
+		}
+		for (size_t i=0;i<terms.size();i++){
+			if (found[i]){
+				iter->second.push_back(terms[i]);
+			}
+		}
+	}
+
+	if (!probedClasses.empty()){
+		for (size_t i=0;i<terms.size();i++){
+			unsigned int term =terms[i];
+			IteratorTripleID *it=NULL;
+			TripleID patternSubject(term,typeID,0);
+			it  = hdt->getTriples()->search(patternSubject);
+			while (it->hasNext())
+			{
+				unsigned int classValueID = it->next()->getObject();
+				if (probedClasses.find(classValueID)!=probedClasses.end()){ //if the class is one of the one we are interested, add the entity
+					classesToEntities[classValueID].push_back(term);
+				}
 
+			}
+			delete it;
 		}
-		delete it;
 	}
 
 	vector<vector<unsigned int>> ret;
@@ -414,22 +1568,117 @@ std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<un
 }
 
 std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<unsigned int, unsigned int>>>> HDTDocument::computeHopsIDs(vector<unsigned int> terms, unsigned int limit, unsigned int offset){
+	collectHops(terms,limit,offset);
+	return outputMatrix();
+}
+
+hop_arrays HDTDocument::computeAllHopsArrays(vector<unsigned int> terms){
+	return computeHopsArrays(terms,hdt->getTriples()->getNumberOfElements(),0);
+}
+
+hop_arrays HDTDocument::computeHopsArrays(vector<unsigned int> terms, unsigned int limit, unsigned int offset){
+	collectHops(terms,limit,offset);
+	vector<unsigned int> mappingLocalToGlobalID;
+	vector<unsigned int> predicates;
+	vector<vector<unsigned int>> rows;
+	vector<vector<unsigned int>> cols;
+	buildHopMatrix(mappingLocalToGlobalID,predicates,rows,cols);
+	// arrays take ownership of the vectors, so nothing is copied
+	std::vector<std::tuple<py::array_t<unsigned int>, py::array_t<unsigned int>>> matrix;
+	for (size_t i=0;i<predicates.size();i++){
+		matrix.push_back(std::make_tuple(toArray(std::move(rows[i])),toArray(std::move(cols[i]))));
+	}
+	return std::make_tuple(toArray(std::move(mappingLocalToGlobalID)),toArray(std::move(predicates)),matrix);
+}
+
+std::tuple<py::array_t<unsigned int>, py::array_t<double>> HDTDocument::propagate(vector<unsigned int> terms,
+		vector<unsigned int> seeds, std::map<unsigned int, double> weights, double defaultWeight,
+		size_t iterations, std::string mode, double alpha, int threads){
+	if (mode!="spread" && mode!="ppr"){
+		throw std::runtime_error("Unknown propagation mode '"+mode+"', expected 'spread' or 'ppr'");
+	}
+	if (alpha<0 || alpha>1){
+		throw std::runtime_error("The teleport probability alpha must be between 0 and 1");
+	}
+	collectHops(terms,hdt->getTriples()->getNumberOfElements(),0);
+	vector<unsigned int> mappingLocalToGlobalID;
+	vector<unsigned int> predicates;
+	vector<vector<unsigned int>> rows;
+	vector<vector<unsigned int>> cols;
+	buildHopMatrix(mappingLocalToGlobalID,predicates,rows,cols);
+	vector<double> activations;
+	{
+		py::gil_scoped_release release;
+		size_t nbNodes = mappingLocalToGlobalID.size();
+		PropagationGraph graph(nbNodes,predicates,rows,cols,weights,defaultWeight);
+		// initial activation, on the seeds found in the subgraph
+		std::unordered_set<unsigned int> seedSet(seeds.begin(),seeds.end());
+		if (seeds.empty()){
+			seedSet.insert(terms.begin(),terms.end());
+		}
+		vector<double> initial(nbNodes,0);
+		size_t nbSeeds=0;
+		for (size_t i=0;i<nbNodes;i++){
+			if (seedSet.count(mappingLocalToGlobalID[i])>0){
+				initial[i]=1;
+				nbSeeds++;
+			}
+		}
+		if (mode=="ppr" && nbSeeds>0){
+			for (size_t i=0;i<nbNodes;i++){
+				initial[i]/=nbSeeds;
+			}
+		}
+		size_t nbThreads = resolveThreads(threads);
+		if (mode=="ppr"){
+			activations = graph.personalizedPageRank(initial,iterations,alpha,nbThreads);
+		}
+		else{
+			activations = graph.spread(initial,iterations,nbThreads);
+		}
+	}
+	return std::make_tuple(toArray(std::move(mappingLocalToGlobalID)),toArray(std::move(activations)));
+}
+
+HopResults * HDTDocument::computeHopsPaged(vector<unsigned int> terms){
+	// the whole subgraph is computed once, without limit nor offset
+	collectHops(terms,hdt->getTriples()->getNumberOfElements(),0);
+	vector<unsigned int> mappingLocalToGlobalID;
+	vector<unsigned int> predicates;
+	vector<vector<unsigned int>> rows;
+	vector<vector<unsigned int>> cols;
+	buildHopMatrix(mappingLocalToGlobalID,predicates,rows,cols);
+	// one entry per edge, in PSO order
+	vector<unsigned int> edgePredicates;
+	vector<unsigned int> edgeRows;
+	vector<unsigned int> edgeCols;
+	for (size_t i=0;i<predicates.size();i++){
+		edgePredicates.insert(edgePredicates.end(),rows[i].size(),predicates[i]);
+		edgeRows.insert(edgeRows.end(),rows[i].begin(),rows[i].end());
+		edgeCols.insert(edgeCols.end(),cols[i].begin(),cols[i].end());
+		vector<unsigned int>().swap(rows[i]);
+		vector<unsigned int>().swap(cols[i]);
+	}
+	return new HopResults(std::move(mappingLocalToGlobalID),std::move(edgePredicates),std::move(edgeRows),std::move(edgeCols));
+}
+
+void HDTDocument::collectHops(vector<unsigned int> &terms, unsigned int limit, unsigned int offset){
 	processedTerms.clear();
 	processedTriples=0;
 	readTriples=0;
+	nbHubs=0;
 	skippedtriplesSet.clear();
 	outtriplesSet.clear();
 	// do a recursive function to iterate terms 2 hops, and keep the result in a TripleList, then order by PSO and dump.
 	if (numHops>=1){
-		TripleComponentRole role=SUBJECT;
-		for (int i=0;i<terms.size();i++){
+		GlobalIDMapping mapping(hdt->getDictionary());
+		for (size_t i=0;i<terms.size();i++){
 			unsigned int term =terms[i];
 			if (continuousDictionary){
-				if (term>hdt->getDictionary()->getNsubjects()){
-					role=OBJECT;
-					// convert the id to the traditional one
-					term = term - (hdt->getDictionary()->getNsubjects()-hdt->getDictionary()->getNshared());
-				}
+				// each term has its own role
+				TripleComponentRole role=mapping.decodingRole(term);
+				// convert the id to the traditional one
+				term = mapping.fromGlobal(term,role);
 				if (term!=0){
 					addhop(term,1,role,limit,offset);
 				}
@@ -444,51 +1693,56 @@ std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<un
 		}
 	}
 	processedTerms.clear();
-	return outputMatrix();
 }
 
 
 std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<unsigned int, unsigned int>>>> HDTDocument::outputMatrix(){
+	vector<unsigned int> mappingLocalToGlobalID;
+	vector<unsigned int> predicates;
+	vector<vector<unsigned int>> rows;
+	vector<vector<unsigned int>> cols;
+	buildHopMatrix(mappingLocalToGlobalID,predicates,rows,cols);
+
+	//prepare output matrix
+	vector<vector<std::tuple<unsigned int, unsigned int>>> matrix(predicates.size());
+	for (size_t i=0;i<predicates.size();i++){
+		for (size_t j=0;j<rows[i].size();j++){
+			matrix[i].push_back(std::make_tuple(rows[i][j],cols[i][j]));
+		}
+	}
+	std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<unsigned int, unsigned int>>>> ret =std::make_tuple(mappingLocalToGlobalID,predicates,matrix);
+	return ret;
+}
 
+void HDTDocument::buildHopMatrix(vector<unsigned int> &mappingLocalToGlobalID,vector<unsigned int> &predicates,vector<vector<unsigned int>> &rows,vector<vector<unsigned int>> &cols){
 
 	//sort PSO and remove duplicates
 	TripleComponentOrder order = PSO;
 	
 	std::vector<TripleID> ordered(outtriplesSet.begin(), outtriplesSet.end());
 	std::sort(ordered.begin(), ordered.end(), TriplesComparator(order));
-	//prepare output matrix
-	vector<vector<std::tuple<unsigned int, unsigned int>>> matrix;
+
+	GlobalIDMapping mapping(hdt->getDictionary());
 
 	// dump output
 	unsigned int prevPredicate=0;
-	vector<unsigned int> predicates;
-
-	vector<std::tuple<unsigned int, unsigned int>> currentPredicateMatrix;
-	map<unsigned int, unsigned int> mappingGlobalToLocalID; //mapping to keep the global to id order
-	vector<unsigned int> mappingLocalToGlobalID;
+	std::unordered_map<unsigned int, unsigned int> mappingGlobalToLocalID; //mapping to keep the global to id order
 
-	//while (it->hasNext())
 	for (auto iter = ordered.begin(); iter != ordered.end(); ++iter)
 	{
-		//TripleID *triple = it->next();
 		TripleID triple = *iter;
 		if (triple.getPredicate()!=prevPredicate){
-			// save previous vector
-			if (currentPredicateMatrix.size()>0){
-				matrix.push_back(currentPredicateMatrix);
-			}
-			currentPredicateMatrix.clear();
-			// store the current one
+			// start the edges of a new predicate
 			predicates.push_back(triple.getPredicate());
+			rows.push_back(vector<unsigned int>());
+			cols.push_back(vector<unsigned int>());
 			prevPredicate=triple.getPredicate();
 		}
 
 		unsigned int subject = triple.getSubject();
 		unsigned int object = triple.getObject();
 		if (continuousDictionary){// change the id of the object to make it continuous
-			if (object>hdt->getDictionary()->getNshared()){
-				object=object+(hdt->getDictionary()->getNsubjects()-hdt->getDictionary()->getNshared());
-			}
+			object = mapping.toGlobal(object,OBJECT);
 		}
 
 		//update the local id mappings
@@ -500,124 +1754,182 @@ std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<un
 			mappingGlobalToLocalID[object]=mappingLocalToGlobalID.size(); //keep new mapping, starting in 0
 			mappingLocalToGlobalID.push_back(object);
 		}
-		// insert tuple with the local mappings;
-		std::tuple<unsigned int, unsigned int> pair = std::make_tuple(mappingGlobalToLocalID.find(subject)->second,mappingGlobalToLocalID.find(object)->second);
-		currentPredicateMatrix.push_back(pair);
-	}
-	// insert the last row
-	if (currentPredicateMatrix.size()>0){
-		matrix.push_back(currentPredicateMatrix);
+		// insert the edge with the local mappings
+		rows.back().push_back(mappingGlobalToLocalID[subject]);
+		cols.back().push_back(mappingGlobalToLocalID[object]);
 	}
 	ordered.clear();
 	skippedtriplesSet.clear();
 	outtriplesSet.clear();
-	mappingGlobalToLocalID.clear();
-
-	std::tuple<vector<unsigned int>,vector<unsigned int>,vector<vector<std::tuple<unsigned int, unsigned int>>>> ret =std::make_tuple(mappingLocalToGlobalID,predicates,matrix);
-	return ret;
 }
 
 void HDTDocument::addhop(size_t termID,int currenthop,TripleComponentRole role, unsigned int limit, unsigned int offset){
 
 	if (processedTriples<limit){ // check if we exceed the limit in terms of number of triples
 		processedTerms.insert(termID);
-		IteratorTripleID *it=NULL;
 		// process as a subjectID
 		if (role==SUBJECT || termID<=hdt->getDictionary()->getNshared()){
-			if (termID<=hdt->getDictionary()->getMaxSubjectID()){
-				TripleID patternSubject(termID,0,0);
-				//if (verbose) cout<< "searching termID "<<termID<<":"<<hdt->getDictionary()->idToString(termID,SUBJECT)<< endl;
-
-				it  = hdt->getTriples()->search(patternSubject);
-				while (it->hasNext())
-				{
-					TripleID *triple = it->next();
-					// check the predicate filter if needed
-					if (preds.size()==0 || preds.find(triple->getPredicate())!=preds.end())
-					{
-						//check the prefix if needed
-						//if (filterPrefixStr=="" || (hdt->getDictionary()->idToString(triple->getObject(),OBJECT).find(filterPrefixStr) != std::string::npos)){
-						if (filterPrefixStr=="" || (includeLiterals==true && triple->getObject()<literalEndID) || ((triple->getObject()>=preffixIniSO) && (triple->getObject() <=preffixEndSO)) || ((triple->getObject()>=preffixIniOBJECT) && (triple->getObject() <=preffixEndOBJECT))){
-							if (processedTriples<limit){ // check if we exceed the limit in terms of number of triples
-								if (readTriples<offset){ //check if we need to skip some offset
-									if (skippedtriplesSet.find(*triple)==skippedtriplesSet.end()){ //only count as skipped if the triple is not skipped before
-										readTriples++;
-										skippedtriplesSet.insert(*triple); //mark as skipped
-									}
-								}
-								else{
-									// only insert as a solution if the triple has not been skipped (sometimes there are repetitions)
-									if (skippedtriplesSet.find(*triple)==skippedtriplesSet.end())
-										outtriplesSet.insert(*triple);
-								}
-								processedTriples=outtriplesSet.size(); // keep the count of the triples for the potential limit
-								if ((currenthop+1)<=numHops){ // we could do it in the beginning of the function but it saves time to do it here and avoid to change the context
-									if (processedTerms.find(triple->getObject())==processedTerms.end()){
-										//if (verbose) cout<<"next hop object"<<endl;
-										addhop(triple->getObject(),currenthop+1,OBJECT,limit,offset);
-									}
-								}
-							}
-						}
-					}
-
+			size_t maxTriples=0;
+			if (termID<=hdt->getDictionary()->getMaxSubjectID() && canExpand(termID,SUBJECT,maxTriples)){
+				hop_neighbourhood triples = hopNeighbourhood(termID,SUBJECT,maxTriples);
+				for (size_t i=0;i<triples->size();i++){
+					TripleID triple = (*triples)[i];
+					visitHopTriple(triple,triple.getObject(),OBJECT,currenthop,limit,offset);
 				}
-				delete it;
 			}
 		}
 		// process as a objectID
 		if (role==OBJECT || termID<=hdt->getDictionary()->getNshared()){
-			if (termID<=hdt->getDictionary()->getMaxObjectID()){
-				TripleID patternObject(0,0,termID);
-				// if (verbose) cout<< "searching termID "<<termID<<":"<<hdt->getDictionary()->idToString(termID,OBJECT)<< endl;
-				it = hdt->getTriples()->search(patternObject);
-				while (it->hasNext())
-				{
-					TripleID *triple = it->next();
-					// For shared SO, skip the special case in which subject=object as it is already done as subject
-					if (termID>hdt->getDictionary()->getNshared() || (triple->getSubject()!=triple->getObject())){
-						// check the predicate filter if needed
-						if (preds.size()==0 || preds.find(triple->getPredicate())!=preds.end())
-						{
-							//check the prefix if needed
-							//if (filterPrefixStr=="" || (hdt->getDictionary()->idToString(triple->getObject(),OBJECT).find(filterPrefixStr) != std::string::npos)){
-							if (filterPrefixStr=="" || (includeLiterals==true && triple->getObject()<literalEndID) || ((triple->getObject()>=preffixIniSO) && (triple->getSubject() <=preffixEndSO)) || ((triple->getObject()>=preffixIniSUBJECT) && (triple->getSubject() <=preffixEndSUBJECT))){
-								if (processedTriples<limit){ // check if we exceed the limit in terms of number of triples
-									if (readTriples<offset){ //check if we need to skip some offset
-										if (skippedtriplesSet.find(*triple)==skippedtriplesSet.end()){ //only count as skipped if the triple is not present before
-											readTriples++;
-											skippedtriplesSet.insert(*triple);
-										}
-									}
-									else{
-										// only insert as a solution if the triple has not been skipped (sometimes there are repetitions)
-										if (skippedtriplesSet.find(*triple)==skippedtriplesSet.end())
-											outtriplesSet.insert(*triple);
-									}
-									processedTriples=outtriplesSet.size(); // keep the count of the triples for the potential limit
-									if ((currenthop+1)<=numHops){ // we could do it in the beginning of the function but it saves time to do it here and avoid to change the context
-										if (processedTerms.find(triple->getSubject())==processedTerms.end()){
-											// if (verbose)cout<<"next hop subject"<<endl;
-											addhop(triple->getSubject(),currenthop+1,SUBJECT,limit,offset);
-										}
-									}
-								}
-							}
-						}
-					}
+			size_t maxTriples=0;
+			if (termID<=hdt->getDictionary()->getMaxObjectID() && canExpand(termID,OBJECT,maxTriples)){
+				hop_neighbourhood triples = hopNeighbourhood(termID,OBJECT,maxTriples);
+				for (size_t i=0;i<triples->size();i++){
+					TripleID triple = (*triples)[i];
+					visitHopTriple(triple,triple.getSubject(),SUBJECT,currenthop,limit,offset);
 				}
-				delete it;
 			}
 		}
-		//delete it;
 	}
 }
+
+void HDTDocument::visitHopTriple(TripleID &triple,size_t next,TripleComponentRole nextRole,int currenthop,unsigned int limit,unsigned int offset){
+	if (processedTriples<limit){ // check if we exceed the limit in terms of number of triples
+		if (readTriples<offset){ //check if we need to skip some offset
+			if (skippedtriplesSet.find(triple)==skippedtriplesSet.end()){ //only count as skipped if the triple is not skipped before
+				readTriples++;
+				skippedtriplesSet.insert(triple); //mark as skipped
+			}
+		}
+		else{
+			// only insert as a solution if the triple has not been skipped (sometimes there are repetitions)
+			if (skippedtriplesSet.find(triple)==skippedtriplesSet.end())
+				outtriplesSet.insert(triple);
+		}
+		processedTriples=outtriplesSet.size(); // keep the count of the triples for the potential limit
+		if ((currenthop+1)<=numHops){ // we could do it in the beginning of the function but it saves time to do it here and avoid to change the context
+			if (processedTerms.find(next)==processedTerms.end()){
+				addhop(next,currenthop+1,nextRole,limit,offset);
+			}
+		}
+	}
+}
+
+bool HDTDocument::canExpand(size_t termID,TripleComponentRole role,size_t &maxTriples){
+	size_t maxDegree = (role==SUBJECT) ? maxOutDegree : maxInDegree;
+	if (maxDegree==0){
+		return true;
+	}
+	// the indexes give the number of triples of a term without reading them
+	TripleID pattern = (role==SUBJECT) ? TripleID(termID,0,0) : TripleID(0,0,termID);
+	IteratorTripleID *it = hdt->getTriples()->search(pattern);
+	size_t degree = it->estimatedNumResults();
+	delete it;
+	if (degree<=maxDegree){
+		return true;
+	}
+	nbHubs++;
+	maxTriples = maxDegree;
+	return truncateHubs;
+}
+
+size_t HDTDocument::getNbHubs(){
+	return nbHubs;
+}
+
+hop_neighbourhood HDTDocument::hopNeighbourhood(size_t termID,TripleComponentRole role,size_t maxTriples){
+	HopCacheKey key = {termID,role,hopConfigHash,hopFilters};
+	if (hopCache){
+		hop_neighbourhood cached = hopCache->get(key);
+		if (cached){
+			return cached;
+		}
+	}
+	std::shared_ptr<std::vector<TripleID>> triples = std::make_shared<std::vector<TripleID>>();
+	TripleID pattern = (role==SUBJECT) ? TripleID(termID,0,0) : TripleID(0,0,termID);
+	IteratorTripleID *it = hdt->getTriples()->search(pattern);
+	size_t nbRead=0;
+	while (it->hasNext() && (maxTriples==0 || nbRead<maxTriples))
+	{
+		TripleID *triple = it->next();
+		nbRead++;
+		// For shared SO, skip the special case in which subject=object as it is already done as subject
+		if (role==OBJECT && termID<=hdt->getDictionary()->getNshared() && triple->getSubject()==triple->getObject()){
+			continue;
+		}
+		// check the predicate filter if needed
+		if (preds.size()>0 && preds.find(triple->getPredicate())==preds.end()){
+			continue;
+		}
+		//check the prefix if needed
+		if (role==SUBJECT){
+			if (filterPrefixStr=="" || (includeLiterals==true && triple->getObject()<literalEndID) || ((triple->getObject()>=preffixIniSO) && (triple->getObject() <=preffixEndSO)) || ((triple->getObject()>=preffixIniOBJECT) && (triple->getObject() <=preffixEndOBJECT))){
+				triples->push_back(*triple);
+			}
+		}
+		else if (filterPrefixStr=="" || (includeLiterals==true && triple->getObject()<literalEndID) || ((triple->getObject()>=preffixIniSO) && (triple->getSubject() <=preffixEndSO)) || ((triple->getObject()>=preffixIniSUBJECT) && (triple->getSubject() <=preffixEndSUBJECT))){
+			triples->push_back(*triple);
+		}
+	}
+	delete it;
+	triples->shrink_to_fit();
+	if (hopCache){
+		hopCache->put(key,triples);
+	}
+	return triples;
+}
+
+void HDTDocument::configureHopCache(size_t maxBytes){
+	if (maxBytes==0){
+		hopCache.reset();
+	}
+	else if (hopCache){
+		hopCache->resize(maxBytes);
+	}
+	else{
+		hopCache = std::make_shared<HopCache>(maxBytes);
+	}
+}
+
+std::map<std::string, size_t> HDTDocument::hopCacheStats(){
+	if (!hopCache){
+		return HopCache(0).getStats();
+	}
+	return hopCache->getStats();
+}
+
+void HDTDocument::clearHopCache(){
+	if (hopCache){
+		hopCache->clear();
+	}
+}
+
 void HDTDocument::remove(){
-	delete hdt;
+	if (!openedFile){
+		// a HDT set with setHDT, owned by this document
+		delete hdt;
+		return;
+	}
+	std::lock_guard<std::mutex> lock(openedHDTsMutex);
+	std::shared_ptr<OpenedHDT> opened = openedFile;
+	openedFile.reset();
+	hdt = NULL;
+	processor = NULL;
+	// the file is freed when no other document uses it, i.e., when the only
+	// other reference is the one of the registry
+	for (auto it = openedHDTs.begin(); it != openedHDTs.end(); ++it){
+		if (it->second==opened && opened.use_count()==2){
+			openedHDTs.erase(it);
+			break;
+		}
+	}
 }
 
 void HDTDocument::setHDT(hdt::HDT* hdtCopy){
 	hdt = hdtCopy;
+	openedFile.reset();
+	hopCache.reset();
+	typeIndex.reset();
+	decodeMutex = std::make_shared<std::mutex>();
 	processor = new QueryProcessor(hdt);
 }
 
@@ -627,6 +1939,10 @@ hdt::HDT* HDTDocument::getHDT(){
 
 void HDTDocument::cloneHDT (HDTDocument doc){
 	hdt = doc.getHDT();
+	openedFile = doc.openedFile;
+	hopCache.reset();
+	typeIndex.reset();
+	decodeMutex = doc.decodeMutex;
 	processor = new QueryProcessor(hdt);
 }
 
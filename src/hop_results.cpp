@@ -0,0 +1,41 @@
+/**
+ * hop_results.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "hop_results.hpp"
+#include <algorithm>
+#include <string>
+
+HopResults::HopResults(std::vector<unsigned int> &&mappingLocalToGlobalID,
+                       std::vector<unsigned int> &&_predicates, std::vector<unsigned int> &&_rows,
+                       std::vector<unsigned int> &&_cols)
+    : entities(toArray(std::move(mappingLocalToGlobalID))), predicates(std::move(_predicates)),
+      rows(std::move(_rows)), cols(std::move(_cols)) {}
+
+py::array_t<unsigned int> HopResults::getEntities() { return entities; }
+
+size_t HopResults::size() { return predicates.size(); }
+
+/*!
+ * Slice a vector, in time proportional to the size of the slice
+ * @param  values Vector to slice
+ * @param  first  First index of the slice
+ * @param  last   Index following the slice
+ * @return        Copy of the slice, as a numpy array
+ */
+static py::array_t<unsigned int> slice(std::vector<unsigned int> &values, size_t first, size_t last) {
+  return toArray(std::vector<unsigned int>(values.begin() + first, values.begin() + last));
+}
+
+hop_page HopResults::page(size_t limit, size_t offset) {
+  size_t first = std::min(offset, size());
+  size_t last = (limit == 0) ? size() : std::min(size(), first + limit);
+  return std::make_tuple(slice(predicates, first, last), slice(rows, first, last),
+                         slice(cols, first, last));
+}
+
+std::string HopResults::python_repr() {
+  return "<HopResults {" + std::to_string(size()) + " edges, " +
+         std::to_string(entities.size()) + " entities}>";
+}
@@ -6,18 +6,45 @@
 #include "join_iterator.hpp"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <algorithm>
 
 /*!
  * Constructor
- * @param _it [description]
+ * @param _it          [description]
+ * @param _decodeMutex Lock held while the QueryProcessor evaluates the join
+ * @param _limit       [description]
+ * @param _offset      [description]
+ * @param _filters     [description]
  */
-JoinIterator::JoinIterator(hdt::VarBindingString *_it) : iterator(_it) {}
+JoinIterator::JoinIterator(hdt::VarBindingString *_it, std::shared_ptr<std::mutex> _decodeMutex,
+                           size_t _limit, size_t _offset, std::vector<TermFilter> _filters)
+    : iterator(_it), pipeline(NULL), dictionary(NULL), decodeMutex(_decodeMutex),
+      limit(_limit), offset(_offset), nbProduced(0), filters(_filters) {}
+
+/*!
+ * Constructor, for a join evaluated by a pipeline of BindingOperators
+ * @param _pipeline Root of the pipeline, owned by the iterator
+ * @param _varNames Names of the join variables, ordered by slot
+ * @param _varRoles Role used to decode the value of each variable
+ * @param _dict     Dictionary used to decode the solution bindings
+ * @param _mapping  Mapping used to convert the global IDs of the solution bindings
+ * @param _decodeMutex Lock held while decoding the solution bindings
+ */
+JoinIterator::JoinIterator(BindingOperator *_pipeline,
+                           std::vector<std::string> _varNames,
+                           std::vector<hdt::TripleComponentRole> _varRoles,
+                           hdt::Dictionary *_dict, GlobalIDMapping _mapping,
+                           std::shared_ptr<std::mutex> _decodeMutex)
+    : iterator(NULL), pipeline(_pipeline), varNames(_varNames),
+      varRoles(_varRoles), dictionary(_dict), mapping(_mapping),
+      decodeMutex(_decodeMutex), limit(0), offset(0), nbProduced(0) {}
 
 /*!
  * Destructor
  */
 JoinIterator::~JoinIterator() {
   delete iterator;
+  delete pipeline;
 }
 
 /*!
@@ -38,14 +65,26 @@ JoinIterator *JoinIterator::python_iter() { return this; }
  * @return [description]
  */
 size_t JoinIterator::estimatedCardinality() {
-  return iterator->estimatedNumResults();
+  if (pipeline != NULL) {
+    return pipeline->estimatedCardinality();
+  }
+  size_t cardinality = iterator->estimatedNumResults();
+  cardinality = (cardinality > offset) ? cardinality - offset : 0;
+  return (limit > 0) ? std::min(cardinality, limit) : cardinality;
 }
 
 /**
  * Reset the iterator into its initial state and restart join processing.
  */
 void JoinIterator::reset() {
-  iterator->goToStart();
+  if (pipeline != NULL) {
+    pipeline->reset();
+  } else {
+    std::lock_guard<std::mutex> lock(*decodeMutex);
+    iterator->goToStart();
+    nbProduced = 0;
+  }
+  hasNextSolution = true;
 }
 
 /*!
@@ -56,18 +95,69 @@ bool JoinIterator::hasNext() {
   return hasNextSolution;
 }
 
+/*!
+ * Move the QueryProcessor iterator to the next solution passing the filters.
+ * Return False if the iterator has ended.
+ * @return True if the iterator holds a solution passing the filters
+ */
+bool JoinIterator::findNextSolution() {
+  while (iterator->findNext()) {
+    bool accepted = true;
+    for (size_t i = 0; i < filters.size() && accepted; i++) {
+      for (unsigned int j = 0; j < iterator->getNumVars(); j++) {
+        if (filters[i].getTarget() == iterator->getVarName(j)) {
+          accepted = filters[i].acceptsTerm(iterator->getVar(j));
+        }
+      }
+    }
+    if (accepted) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * Return the next set of solutions bindings, or raise py::StopIteration if the iterator
  * has ended. Used to implement Python Itertor protocol.
  * @return [description]
  */
 solution_bindings JoinIterator::next() {
-  hasNextSolution = iterator->findNext();
+  // the QueryProcessor decodes terms while it evaluates the join, while
+  // pipelines work on IDs, and only need the lock to decode the solutions
+  std::unique_lock<std::mutex> lock(*decodeMutex, std::defer_lock);
+  if (pipeline == NULL) {
+    lock.lock();
+  }
+  if (pipeline != NULL) {
+    hasNextSolution = pipeline->next(row);
+  } else if (limit > 0 && nbProduced >= limit) {
+    hasNextSolution = false;
+  } else {
+    // skip the first offset solutions
+    if (nbProduced == 0) {
+      for (size_t i = 0; i < offset && findNextSolution(); i++) {}
+    }
+    hasNextSolution = findNextSolution();
+    nbProduced++;
+  }
   // stop iteration if the iterator has ended
   if (!hasNextSolution) {
     throw pybind11::stop_iteration();
   }
   solution_bindings solutions = new std::set<single_binding>();
+  if (pipeline != NULL) {
+    // decode solution bindings, from global IDs to RDF terms
+    lock.lock();
+    for (size_t i = 0; i < varNames.size(); i++) {
+      hdt::TripleComponentRole role = varRoles[i];
+      if (role != hdt::PREDICATE) {
+        role = mapping.decodingRole(row[i]);
+      }
+      solutions->insert(std::make_tuple(varNames[i], dictionary->idToString(mapping.fromGlobal(row[i], role), role)));
+    }
+    return solutions;
+  }
   // build solution bindings
   for(unsigned int i = 0; i < iterator->getNumVars(); i++) {
     solutions->insert(std::make_tuple(iterator->getVarName(i), iterator->getVar(i)));
@@ -0,0 +1,808 @@
+/**
+ * join_operators.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "join_operators.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Role of each position in a triple pattern
+static const hdt::TripleComponentRole POSITION_ROLES[3] = {
+    hdt::SUBJECT, hdt::PREDICATE, hdt::OBJECT};
+
+// Maximum number of partitions created when a hash join spills on disk
+static const size_t MAX_PARTITIONS = 256;
+
+// Number of solutions sent at once by a worker of a ParallelJoin
+static const size_t WORKER_BATCH_SIZE = 512;
+
+// Number of solutions handed out at once by a SharedScan
+static const size_t SHARED_SCAN_CHUNK_SIZE = 1024;
+
+/*!
+ * Get the value at a position of a TripleID
+ * @param  triple   Triple made of HDT ids
+ * @param  position 0 for the subject, 1 for the predicate, 2 for the object
+ * @return          The HDT id at this position
+ */
+inline size_t getComponent(const hdt::TripleID &triple, int position) {
+  if (position == 0) {
+    return triple.getSubject();
+  } else if (position == 1) {
+    return triple.getPredicate();
+  }
+  return triple.getObject();
+}
+
+size_t hashKey(const size_t *row, const std::vector<int> &keyVars) {
+  size_t hash = 0;
+  for (size_t i = 0; i < keyVars.size(); i++) {
+    hash ^= row[keyVars[i]] + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+bool bindTriple(const PatternID &pattern, const hdt::TripleID &triple,
+                const GlobalIDMapping &mapping, binding_row &row) {
+  for (int i = 0; i < 3; i++) {
+    int var = pattern.vars[i];
+    if (var >= 0) {
+      size_t value = mapping.toGlobal(getComponent(triple, i), POSITION_ROLES[i]);
+      if (row[var] == 0) {
+        row[var] = value;
+      } else if (row[var] != value) {
+        // same variable bound twice to different values, e.g., { ?x ?p ?x }
+        return false;
+      }
+    }
+  }
+  // filters are checked on HDT ids, before any conversion
+  for (size_t i = 0; i < pattern.filters.size(); i++) {
+    const TermFilter &filter = pattern.filters[i];
+    int position = std::find(pattern.vars, pattern.vars + 3, filter.getSlot()) - pattern.vars;
+    if (!filter.accepts(getComponent(triple, position), POSITION_ROLES[position])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool bindPattern(const PatternID &pattern, const binding_row &row,
+                 const GlobalIDMapping &mapping, hdt::TripleID &result) {
+  size_t ids[3] = {pattern.ids.getSubject(), pattern.ids.getPredicate(),
+                   pattern.ids.getObject()};
+  for (int i = 0; i < 3; i++) {
+    int var = pattern.vars[i];
+    if (var >= 0 && row[var] != 0) {
+      ids[i] = mapping.fromGlobal(row[var], POSITION_ROLES[i]);
+      if (ids[i] == 0) {
+        return false;
+      }
+    }
+  }
+  result = hdt::TripleID(ids[0], ids[1], ids[2]);
+  return true;
+}
+
+/*!
+ * Constructor
+ * @param _triples Triples of the HDT document
+ * @param _pattern Triple pattern to evaluate
+ * @param _mapping Mapping used to convert HDT ids into global IDs
+ * @param _nbVars  Number of variables of the join
+ */
+PatternScan::PatternScan(hdt::Triples *_triples, PatternID _pattern,
+                         GlobalIDMapping _mapping, size_t _nbVars)
+    : triples(_triples), pattern(_pattern), mapping(_mapping),
+      nbVars(_nbVars), iterator(NULL), start(0), count(0), nbRead(0) {
+  iterator = triples->search(pattern.ids);
+  cardinality = iterator->estimatedNumResults();
+}
+
+/*!
+ * Destructor
+ */
+PatternScan::~PatternScan() { delete iterator; }
+
+void PatternScan::restrictPositions(size_t _start, size_t _count) {
+  start = _start;
+  count = _count;
+  nbRead = 0;
+  if (start > 0) {
+    iterator->goTo(start);
+  }
+}
+
+bool PatternScan::next(binding_row &row) {
+  while (iterator->hasNext() && (count == 0 || nbRead < count)) {
+    hdt::TripleID *triple = iterator->next();
+    nbRead++;
+    row.assign(nbVars, 0);
+    if (bindTriple(pattern, *triple, mapping, row)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PatternScan::reset() {
+  delete iterator;
+  iterator = triples->search(pattern.ids);
+  nbRead = 0;
+  if (start > 0) {
+    iterator->goTo(start);
+  }
+}
+
+size_t PatternScan::estimatedCardinality() {
+  return (count > 0) ? count : cardinality;
+}
+
+/*!
+ * Constructor
+ * @param _scan     Scan of the driving pattern, owned by the SharedScan
+ * @param _splitVar Slot of the variable whose values are not split between
+ *                  chunks, or -1 to split chunks anywhere
+ * @param _nbVars   Number of variables of the join
+ */
+SharedScan::SharedScan(PatternScan *_scan, int _splitVar, size_t _nbVars)
+    : scan(_scan), splitVar(_splitVar), nbVars(_nbVars), hasPending(false) {}
+
+/*!
+ * Destructor
+ */
+SharedScan::~SharedScan() { delete scan; }
+
+bool SharedScan::nextChunk(std::vector<size_t> &chunk) {
+  std::lock_guard<std::mutex> lock(mutex);
+  chunk.clear();
+  binding_row row;
+  if (hasPending) {
+    chunk.insert(chunk.end(), pending.begin(), pending.end());
+    hasPending = false;
+  }
+  while (chunk.size() < SHARED_SCAN_CHUNK_SIZE * nbVars && scan->next(row)) {
+    chunk.insert(chunk.end(), row.begin(), row.end());
+  }
+  // extend the chunk up to the next value of the split variable
+  if (splitVar >= 0 && !chunk.empty()) {
+    size_t last = chunk[chunk.size() - nbVars + splitVar];
+    while (scan->next(row)) {
+      if (row[splitVar] != last) {
+        pending = row;
+        hasPending = true;
+        break;
+      }
+      chunk.insert(chunk.end(), row.begin(), row.end());
+    }
+  }
+  return !chunk.empty();
+}
+
+void SharedScan::reset() {
+  std::lock_guard<std::mutex> lock(mutex);
+  scan->reset();
+  hasPending = false;
+}
+
+size_t SharedScan::estimatedCardinality() { return scan->estimatedCardinality(); }
+
+/*!
+ * Constructor
+ * @param _shared Scan shared by the workers
+ * @param _nbVars Number of variables of the join
+ */
+ChunkScan::ChunkScan(std::shared_ptr<SharedScan> _shared, size_t _nbVars)
+    : shared(_shared), nbVars(_nbVars), chunkPos(0) {}
+
+bool ChunkScan::next(binding_row &row) {
+  if (chunkPos >= chunk.size()) {
+    chunkPos = 0;
+    if (!shared->nextChunk(chunk)) {
+      return false;
+    }
+  }
+  row.assign(chunk.begin() + chunkPos, chunk.begin() + chunkPos + nbVars);
+  chunkPos += nbVars;
+  return true;
+}
+
+void ChunkScan::reset() {
+  shared->reset();
+  chunk.clear();
+  chunkPos = 0;
+}
+
+size_t ChunkScan::estimatedCardinality() { return shared->estimatedCardinality(); }
+
+/*!
+ * Constructor
+ * @param _left             Operator producing the bindings used to substitute the right pattern
+ * @param _triples          Triples of the HDT document
+ * @param _right            Triple pattern searched for each set of bindings
+ * @param _mapping          Mapping used to convert HDT ids into global IDs
+ * @param _rightCardinality Estimated number of triples matching the right pattern
+ */
+BindJoin::BindJoin(BindingOperator *_left, hdt::Triples *_triples,
+                   PatternID _right, GlobalIDMapping _mapping,
+                   size_t _rightCardinality)
+    : left(_left), triples(_triples), right(_right), mapping(_mapping),
+      rightCardinality(_rightCardinality), iterator(NULL) {}
+
+/*!
+ * Destructor
+ */
+BindJoin::~BindJoin() {
+  delete iterator;
+  delete left;
+}
+
+bool BindJoin::next(binding_row &row) {
+  while (true) {
+    if (iterator != NULL) {
+      while (iterator->hasNext()) {
+        hdt::TripleID *triple = iterator->next();
+        row = current;
+        if (bindTriple(right, *triple, mapping, row)) {
+          return true;
+        }
+      }
+      delete iterator;
+      iterator = NULL;
+    }
+    // fetch the next set of bindings from the left operator
+    if (!left->next(current)) {
+      return false;
+    }
+    hdt::TripleID tp;
+    if (bindPattern(right, current, mapping, tp)) {
+      iterator = triples->search(tp);
+    }
+  }
+}
+
+void BindJoin::reset() {
+  delete iterator;
+  iterator = NULL;
+  left->reset();
+}
+
+size_t BindJoin::estimatedCardinality() {
+  return std::max(left->estimatedCardinality(), rightCardinality);
+}
+
+/*!
+ * Constructor
+ * @param _build        Operator read into the hash table, owned by the join
+ * @param _probe        Operator probing the hash table, owned by the join
+ * @param _keyVars      Slots of the variables shared by both inputs
+ * @param _nbVars       Number of variables of the join
+ * @param _memoryBudget Maximum size of the hash table, in bytes, before partitioning on disk
+ */
+HashJoin::HashJoin(BindingOperator *_build, BindingOperator *_probe,
+                   std::vector<int> _keyVars, size_t _nbVars,
+                   size_t _memoryBudget)
+    : build(_build), probe(_probe), keyVars(_keyVars), nbVars(_nbVars),
+      memoryBudget(_memoryBudget), built(false), spilled(false),
+      currentPartition(0), matchPos(0) {}
+
+/*!
+ * Destructor
+ */
+HashJoin::~HashJoin() {
+  closePartitions();
+  delete build;
+  delete probe;
+}
+
+size_t HashJoin::keyHash(const binding_row &row) { return hashKey(row.data(), keyVars); }
+
+size_t HashJoin::partitionOf(const binding_row &row) {
+  // use other bits than the hash table buckets, so partitions do not skew them
+  size_t hash = keyHash(row);
+  return ((hash >> 16) ^ (hash * 31)) % buildPartitions.size();
+}
+
+size_t HashJoin::memoryUsage() {
+  return buildRows.size() * sizeof(size_t) + table.size() * HASH_ENTRY_OVERHEAD;
+}
+
+void HashJoin::insert(const binding_row &row) {
+  table.insert(std::make_pair(keyHash(row), buildRows.size()));
+  buildRows.insert(buildRows.end(), row.begin(), row.end());
+}
+
+/*!
+ * Read the whole build side into the hash table, and partition both inputs
+ * on disk if the memory budget is exceeded.
+ */
+void HashJoin::buildTable() {
+  binding_row row;
+  while (build->next(row)) {
+    if (spilled) {
+      fwrite(row.data(), sizeof(size_t), nbVars, buildPartitions[partitionOf(row)]);
+    } else {
+      insert(row);
+      if (memoryUsage() > memoryBudget) {
+        spill();
+      }
+    }
+  }
+  if (spilled) {
+    while (probe->next(row)) {
+      fwrite(row.data(), sizeof(size_t), nbVars, probePartitions[partitionOf(row)]);
+    }
+    for (size_t i = 0; i < buildPartitions.size(); i++) {
+      rewind(buildPartitions[i]);
+      rewind(probePartitions[i]);
+    }
+    currentPartition = 0;
+    loadPartition(currentPartition);
+  }
+  built = true;
+}
+
+/*!
+ * Move the hash table on disk, into partitions
+ */
+void HashJoin::spill() {
+  size_t rowSize = nbVars * sizeof(size_t) + HASH_ENTRY_OVERHEAD;
+  size_t expectedSize = build->estimatedCardinality() * rowSize;
+  size_t nbPartitions = std::min(MAX_PARTITIONS, 2 * (expectedSize / memoryBudget) + 2);
+  for (size_t i = 0; i < nbPartitions; i++) {
+    FILE *buildFile = tmpfile();
+    FILE *probeFile = tmpfile();
+    if (buildFile == NULL || probeFile == NULL) {
+      if (buildFile != NULL) {
+        fclose(buildFile);
+      }
+      if (probeFile != NULL) {
+        fclose(probeFile);
+      }
+      closePartitions();
+      throw std::runtime_error("Cannot create temporary files to partition the hash join");
+    }
+    buildPartitions.push_back(buildFile);
+    probePartitions.push_back(probeFile);
+  }
+  spilled = true;
+  // flush the rows already in memory
+  binding_row row(nbVars);
+  for (size_t offset = 0; offset < buildRows.size(); offset += nbVars) {
+    std::copy(buildRows.begin() + offset, buildRows.begin() + offset + nbVars, row.begin());
+    fwrite(row.data(), sizeof(size_t), nbVars, buildPartitions[partitionOf(row)]);
+  }
+  std::vector<size_t>().swap(buildRows);
+  std::unordered_multimap<size_t, size_t>().swap(table);
+}
+
+/*!
+ * Load a build partition into the hash table.
+ * A partition larger than the memory budget is still loaded as a whole.
+ * @param partition Index of the partition
+ */
+void HashJoin::loadPartition(size_t partition) {
+  buildRows.clear();
+  table.clear();
+  binding_row row(nbVars);
+  while (fread(row.data(), sizeof(size_t), nbVars, buildPartitions[partition]) == nbVars) {
+    insert(row);
+  }
+}
+
+bool HashJoin::nextProbeRow() {
+  if (!spilled) {
+    return probe->next(probeRow);
+  }
+  probeRow.resize(nbVars);
+  while (currentPartition < probePartitions.size()) {
+    if (fread(probeRow.data(), sizeof(size_t), nbVars, probePartitions[currentPartition]) == nbVars) {
+      return true;
+    }
+    currentPartition++;
+    if (currentPartition < buildPartitions.size()) {
+      loadPartition(currentPartition);
+    }
+  }
+  return false;
+}
+
+void HashJoin::closePartitions() {
+  for (size_t i = 0; i < buildPartitions.size(); i++) {
+    fclose(buildPartitions[i]);
+    fclose(probePartitions[i]);
+  }
+  buildPartitions.clear();
+  probePartitions.clear();
+  spilled = false;
+}
+
+bool HashJoin::next(binding_row &row) {
+  if (!built) {
+    buildTable();
+  }
+  while (true) {
+    if (matchPos < matches.size()) {
+      size_t offset = matches[matchPos++];
+      row = probeRow;
+      for (size_t i = 0; i < nbVars; i++) {
+        if (row[i] == 0) {
+          row[i] = buildRows[offset + i];
+        }
+      }
+      return true;
+    }
+    if (!nextProbeRow()) {
+      return false;
+    }
+    // find the build rows with the same join key
+    matches.clear();
+    matchPos = 0;
+    auto range = table.equal_range(keyHash(probeRow));
+    for (auto it = range.first; it != range.second; it++) {
+      bool sameKey = true;
+      for (size_t i = 0; i < keyVars.size() && sameKey; i++) {
+        sameKey = buildRows[it->second + keyVars[i]] == probeRow[keyVars[i]];
+      }
+      if (sameKey) {
+        matches.push_back(it->second);
+      }
+    }
+  }
+}
+
+void HashJoin::reset() {
+  closePartitions();
+  buildRows.clear();
+  table.clear();
+  matches.clear();
+  matchPos = 0;
+  currentPartition = 0;
+  built = false;
+  build->reset();
+  probe->reset();
+}
+
+size_t HashJoin::estimatedCardinality() {
+  return std::max(build->estimatedCardinality(), probe->estimatedCardinality());
+}
+
+/*!
+ * Constructor
+ * @param _build   Operator read into the hash table, owned by the table
+ * @param _keyVars Slots of the variables of the join key
+ * @param _nbVars  Number of variables of the join
+ */
+SharedHashTable::SharedHashTable(BindingOperator *_build, std::vector<int> _keyVars,
+                                 size_t _nbVars)
+    : build(_build), keyVars(_keyVars), nbVars(_nbVars), built(false) {}
+
+/*!
+ * Destructor
+ */
+SharedHashTable::~SharedHashTable() { delete build; }
+
+void SharedHashTable::ensureBuilt() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (built) {
+    return;
+  }
+  binding_row row;
+  while (build->next(row)) {
+    table.insert(std::make_pair(hashKey(row.data(), keyVars), rows.size()));
+    rows.insert(rows.end(), row.begin(), row.end());
+  }
+  built = true;
+}
+
+void SharedHashTable::findMatches(const binding_row &row, std::vector<size_t> &matches) const {
+  matches.clear();
+  auto range = table.equal_range(hashKey(row.data(), keyVars));
+  for (auto it = range.first; it != range.second; it++) {
+    bool sameKey = true;
+    for (size_t i = 0; i < keyVars.size() && sameKey; i++) {
+      sameKey = rows[it->second + keyVars[i]] == row[keyVars[i]];
+    }
+    if (sameKey) {
+      matches.push_back(it->second);
+    }
+  }
+}
+
+const size_t *SharedHashTable::getRow(size_t offset) const { return rows.data() + offset; }
+
+size_t SharedHashTable::estimatedCardinality() { return build->estimatedCardinality(); }
+
+/*!
+ * Constructor
+ * @param _probe  Operator probing the hash table, owned by the join
+ * @param _table  Hash table shared with the other workers
+ * @param _nbVars Number of variables of the join
+ */
+SharedHashJoin::SharedHashJoin(BindingOperator *_probe, std::shared_ptr<SharedHashTable> _table,
+                               size_t _nbVars)
+    : probe(_probe), table(_table), nbVars(_nbVars), ready(false), matchPos(0) {}
+
+/*!
+ * Destructor
+ */
+SharedHashJoin::~SharedHashJoin() { delete probe; }
+
+bool SharedHashJoin::next(binding_row &row) {
+  if (!ready) {
+    table->ensureBuilt();
+    ready = true;
+  }
+  while (matchPos >= matches.size()) {
+    if (!probe->next(probeRow)) {
+      return false;
+    }
+    table->findMatches(probeRow, matches);
+    matchPos = 0;
+  }
+  const size_t *match = table->getRow(matches[matchPos++]);
+  row = probeRow;
+  for (size_t i = 0; i < nbVars; i++) {
+    if (row[i] == 0) {
+      row[i] = match[i];
+    }
+  }
+  return true;
+}
+
+void SharedHashJoin::reset() {
+  // the hash table does not depend on the probe side, so it is kept
+  probe->reset();
+  matches.clear();
+  matchPos = 0;
+}
+
+size_t SharedHashJoin::estimatedCardinality() {
+  return std::max(table->estimatedCardinality(), probe->estimatedCardinality());
+}
+
+/*!
+ * Constructor
+ * @param _driving  Scan of the most selective pattern of the star, or of a slice of it
+ * @param _triples  Triples of the HDT document, used to read adjacency lists
+ * @param _patterns All patterns of the star, with constant predicates
+ * @param _mapping  Mapping between HDT IDs and global IDs of the bindings
+ * @param _nbVars   Number of variables of the join
+ */
+StarJoin::StarJoin(BindingOperator *_driving, hdt::Triples *_triples,
+                   std::vector<PatternID> _patterns, GlobalIDMapping _mapping,
+                   size_t _nbVars)
+    : driving(_driving), triples(_triples), patterns(_patterns),
+      mapping(_mapping), nbVars(_nbVars), subjectVar(_patterns[0].vars[0]),
+      lastSubject(0), matches(_patterns.size()),
+      positions(_patterns.size(), 0), hasSolutions(false) {}
+
+/*!
+ * Destructor
+ */
+StarJoin::~StarJoin() { delete driving; }
+
+/*!
+ * Test if an object passes the filters of a pattern on its object variable
+ * @param  pattern Pattern of the star
+ * @param  object  HDT ID of the object
+ * @return         True if the object passes all filters on the object variable
+ */
+bool StarJoin::acceptsObject(const PatternID &pattern, size_t object) {
+  for (size_t i = 0; i < pattern.filters.size(); i++) {
+    if (pattern.filters[i].getSlot() == pattern.vars[2] &&
+        !pattern.filters[i].accepts(object, hdt::OBJECT)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Scan the adjacency list of a subject, and find the objects matching each pattern.
+ * Returns False if one pattern has no match.
+ * @param  subject HDT ID of the subject
+ * @return         True if every pattern has at least one match
+ */
+bool StarJoin::readSubject(size_t subject) {
+  for (size_t i = 0; i < patterns.size(); i++) {
+    matches[i].clear();
+    positions[i] = 0;
+  }
+  hdt::TripleID pattern(subject, 0, 0);
+  hdt::IteratorTripleID *it = triples->search(pattern);
+  while (it->hasNext()) {
+    hdt::TripleID *triple = it->next();
+    for (size_t i = 0; i < patterns.size(); i++) {
+      const hdt::TripleID &ids = patterns[i].ids;
+      if (triple->getPredicate() == ids.getPredicate() &&
+          (ids.getObject() == 0 || triple->getObject() == ids.getObject()) &&
+          acceptsObject(patterns[i], triple->getObject())) {
+        matches[i].push_back(mapping.toGlobal(triple->getObject(), hdt::OBJECT));
+      }
+    }
+  }
+  delete it;
+  for (size_t i = 0; i < patterns.size(); i++) {
+    if (matches[i].empty()) {
+      return false;
+    }
+  }
+  current.assign(nbVars, 0);
+  current[subjectVar] = subject;
+  return true;
+}
+
+bool StarJoin::next(binding_row &row) {
+  while (!hasSolutions) {
+    // find the next candidate subject, skipping duplicates
+    binding_row candidate;
+    if (!driving->next(candidate)) {
+      return false;
+    }
+    if (candidate[subjectVar] != lastSubject) {
+      lastSubject = candidate[subjectVar];
+      hasSolutions = readSubject(lastSubject);
+    }
+  }
+  // produce the cartesian product of the matches of each pattern
+  row = current;
+  for (size_t i = 0; i < patterns.size(); i++) {
+    if (patterns[i].vars[2] >= 0) {
+      row[patterns[i].vars[2]] = matches[i][positions[i]];
+    }
+  }
+  hasSolutions = false;
+  for (size_t i = 0; i < patterns.size() && !hasSolutions; i++) {
+    if (patterns[i].vars[2] >= 0 && positions[i] + 1 < matches[i].size()) {
+      positions[i]++;
+      hasSolutions = true;
+    } else {
+      positions[i] = 0;
+    }
+  }
+  return true;
+}
+
+void StarJoin::reset() {
+  driving->reset();
+  lastSubject = 0;
+  hasSolutions = false;
+}
+
+size_t StarJoin::estimatedCardinality() { return driving->estimatedCardinality(); }
+
+SliceOperator::SliceOperator(BindingOperator *_child, size_t _limit, size_t _offset)
+    : child(_child), limit(_limit), offset(_offset), nbProduced(0),
+      skipped(false), done(false) {}
+
+SliceOperator::~SliceOperator() { delete child; }
+
+bool SliceOperator::next(binding_row &row) {
+  if (!skipped) {
+    skipped = true;
+    for (size_t i = 0; i < offset && !done; i++) {
+      done = !child->next(row);
+    }
+  }
+  // do not pull more solutions from the pipeline once the limit is reached
+  if (done || (limit > 0 && nbProduced >= limit)) {
+    return false;
+  }
+  done = !child->next(row);
+  if (done) {
+    return false;
+  }
+  nbProduced++;
+  return true;
+}
+
+void SliceOperator::reset() {
+  child->reset();
+  nbProduced = 0;
+  skipped = false;
+  done = false;
+}
+
+size_t SliceOperator::estimatedCardinality() {
+  size_t cardinality = child->estimatedCardinality();
+  cardinality = (cardinality > offset) ? cardinality - offset : 0;
+  return (limit > 0) ? std::min(cardinality, limit) : cardinality;
+}
+
+/*!
+ * Constructor
+ * @param _pipelines     Pipelines evaluated by the workers, one per worker, owned by the join
+ * @param _nbVars        Number of variables of the join
+ * @param _cardinality   Estimated number of solutions of the join
+ * @param _queueCapacity Maximum number of batches of solutions waiting in the queue
+ */
+ParallelJoin::ParallelJoin(std::vector<BindingOperator *> _pipelines,
+                           size_t _nbVars, size_t _cardinality,
+                           size_t _queueCapacity)
+    : pipelines(_pipelines), nbVars(_nbVars), cardinality(_cardinality),
+      queueCapacity(_queueCapacity), queue(NULL), batchPos(0) {}
+
+/*!
+ * Destructor
+ */
+ParallelJoin::~ParallelJoin() {
+  stop();
+  for (size_t i = 0; i < pipelines.size(); i++) {
+    delete pipelines[i];
+  }
+}
+
+void ParallelJoin::start() {
+  queue = new BoundedQueue<std::vector<size_t>>(queueCapacity, pipelines.size());
+  error = nullptr;
+  for (size_t i = 0; i < pipelines.size(); i++) {
+    workers.push_back(std::thread(&ParallelJoin::runWorker, this, pipelines[i]));
+  }
+}
+
+void ParallelJoin::stop() {
+  if (queue != NULL) {
+    queue->cancel();
+    for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].join();
+    }
+    workers.clear();
+    delete queue;
+    queue = NULL;
+  }
+  batch.clear();
+  batchPos = 0;
+}
+
+void ParallelJoin::runWorker(BindingOperator *pipeline) {
+  try {
+    binding_row row;
+    std::vector<size_t> solutions;
+    bool cancelled = false;
+    while (!cancelled && pipeline->next(row)) {
+      solutions.insert(solutions.end(), row.begin(), row.end());
+      if (solutions.size() >= WORKER_BATCH_SIZE * nbVars) {
+        cancelled = !queue->push(solutions);
+        solutions.clear();
+      }
+    }
+    if (!cancelled && solutions.size() > 0) {
+      queue->push(solutions);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    error = std::current_exception();
+  }
+  queue->producerDone();
+}
+
+bool ParallelJoin::next(binding_row &row) {
+  if (queue == NULL) {
+    start();
+  }
+  if (batchPos >= batch.size()) {
+    batchPos = 0;
+    if (!queue->pop(batch)) {
+      batch.clear();
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      return false;
+    }
+  }
+  row.assign(batch.begin() + batchPos, batch.begin() + batchPos + nbVars);
+  batchPos += nbVars;
+  return true;
+}
+
+void ParallelJoin::reset() {
+  stop();
+  for (size_t i = 0; i < pipelines.size(); i++) {
+    pipelines[i]->reset();
+  }
+}
+
+size_t ParallelJoin::estimatedCardinality() { return cardinality; }
@@ -0,0 +1,432 @@
+/**
+ * join_planner.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "join_planner.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Relative cost of an index probe against the cost of inserting or
+// probing a row in a hash table
+static const size_t INDEX_PROBE_COST = 16;
+
+// Maximum number of batches of solutions waiting to be consumed in a parallel join
+static const size_t PARALLEL_QUEUE_CAPACITY = 64;
+
+/*!
+ * Constructor
+ * @param _hdt      HDT document queried
+ * @param _patterns Triple patterns of the join, where variables start with '?'
+ * @param _filters  Filters on the join variables, as (variable, operator[, argument])
+ */
+JoinPlanner::JoinPlanner(hdt::HDT *_hdt, std::vector<triple> &_patterns,
+                         std::vector<filter_expr> _filters)
+    : hdt(_hdt), mapping(_hdt->getDictionary()), supported(true),
+      hashJoinMinCardinality(HASH_JOIN_MIN_CARDINALITY),
+      parallelMinCardinality(PARALLEL_MIN_CARDINALITY) {
+  hdt::Dictionary *dict = hdt->getDictionary();
+  const hdt::TripleComponentRole roles[3] = {hdt::SUBJECT, hdt::PREDICATE, hdt::OBJECT};
+  std::string terms[3];
+
+  for (auto it = _patterns.begin(); it != _patterns.end(); it++) {
+    std::tie(terms[0], terms[1], terms[2]) = *it;
+    PatternID pattern;
+    size_t ids[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+      if (terms[i].size() > 0 && terms[i].at(0) == '?') {
+        pattern.vars[i] = addVariable(terms[i], roles[i]);
+      } else {
+        pattern.vars[i] = -1;
+        ids[i] = dict->stringToId(terms[i], roles[i]);
+        // unknown RDF terms are left to the QueryProcessor
+        supported = supported && ids[i] != 0;
+      }
+    }
+    pattern.ids = hdt::TripleID(ids[0], ids[1], ids[2]);
+    patterns.push_back(pattern);
+  }
+
+  // compile filters on join variables
+  for (auto it = _filters.begin(); it != _filters.end(); it++) {
+    std::string target = (it->size() > 0) ? it->at(0) : "";
+    size_t var = std::find(varNames.begin(), varNames.end(), target) - varNames.begin();
+    if (var == varNames.size()) {
+      throw std::runtime_error("Cannot filter on '" + target + "': not a variable of the join");
+    }
+    filters.push_back(TermFilter(dict, *it, var));
+  }
+
+  // estimate the cardinality of each pattern
+  if (supported) {
+    for (size_t i = 0; i < patterns.size(); i++) {
+      hdt::IteratorTripleID *it = hdt->getTriples()->search(patterns[i].ids);
+      cardinalities.push_back(it->estimatedNumResults());
+      delete it;
+    }
+  }
+}
+
+/*!
+ * Register a join variable and returns its slot.
+ * Variables used both as predicates and as subjects/objects cannot be joined
+ * on their IDs, so such joins are left to the QueryProcessor.
+ * @param  name Name of the variable, with its leading '?'
+ * @param  role Role of the variable in the pattern where it appears
+ * @return      The slot of the variable in the solution bindings
+ */
+int JoinPlanner::addVariable(std::string name, hdt::TripleComponentRole role) {
+  for (size_t i = 0; i < varNames.size(); i++) {
+    if (varNames[i] == name) {
+      if ((varRoles[i] == hdt::PREDICATE) != (role == hdt::PREDICATE)) {
+        supported = false;
+      }
+      return i;
+    }
+  }
+  varNames.push_back(name);
+  varRoles.push_back(role);
+  return varNames.size() - 1;
+}
+
+/*!
+ * Order the triple patterns, starting from the most selective one, and decide
+ * which joins are evaluated using hash joins.
+ * With several workers, the driving pattern is split between workers, which
+ * share the hash tables. Shared hash tables are kept in memory, so they are
+ * only used when their build input fits the memory budget.
+ * @param nbWorkers     Number of workers sharing the driving pattern
+ * @param memoryBudget  Memory budget of all hash joins, in bytes
+ * @param allowHashJoin If False, only use index nested loops, which produce
+ *                      the first solutions without reading their inputs entirely
+ */
+void JoinPlanner::orderPatterns(size_t nbWorkers, size_t memoryBudget, bool allowHashJoin) {
+  std::vector<bool> used(patterns.size(), false);
+  std::vector<bool> bound(varNames.size(), false);
+  order.clear();
+  useHashJoin.clear();
+
+  // start with the most selective pattern
+  size_t first = std::min_element(cardinalities.begin(), cardinalities.end()) - cardinalities.begin();
+  size_t leftCardinality = cardinalities[first];
+  used[first] = true;
+  order.push_back(first);
+  useHashJoin.push_back(false);
+  for (int j = 0; j < 3; j++) {
+    if (patterns[first].vars[j] >= 0) {
+      bound[patterns[first].vars[j]] = true;
+    }
+  }
+
+  // then, pick the most selective pattern connected to the previous ones
+  for (size_t step = 1; step < patterns.size(); step++) {
+    size_t next = patterns.size();
+    bool nextIsConnected = false;
+    for (size_t i = 0; i < patterns.size(); i++) {
+      if (used[i]) {
+        continue;
+      }
+      bool connected = false;
+      for (int j = 0; j < 3; j++) {
+        connected = connected || (patterns[i].vars[j] >= 0 && bound[patterns[i].vars[j]]);
+      }
+      if (next == patterns.size() || (connected && !nextIsConnected) ||
+          (connected == nextIsConnected && cardinalities[i] < cardinalities[next])) {
+        next = i;
+        nextIsConnected = connected;
+      }
+    }
+    size_t rightCardinality = cardinalities[next];
+    size_t workerCardinality = leftCardinality / nbWorkers;
+    // index probes cost INDEX_PROBE_COST per set of bindings of the left side,
+    // while a hash join reads both sides once
+    bool hashJoin = allowHashJoin && nextIsConnected &&
+                    std::min(leftCardinality, rightCardinality) >= hashJoinMinCardinality &&
+                    workerCardinality + rightCardinality < workerCardinality * INDEX_PROBE_COST;
+    if (nbWorkers > 1) {
+      hashJoin = hashJoin && rightCardinality * (varNames.size() * sizeof(size_t) + HASH_ENTRY_OVERHEAD) <= memoryBudget;
+    }
+    used[next] = true;
+    order.push_back(next);
+    useHashJoin.push_back(hashJoin);
+    for (int j = 0; j < 3; j++) {
+      if (patterns[next].vars[j] >= 0) {
+        bound[patterns[next].vars[j]] = true;
+      }
+    }
+    leftCardinality = std::max(leftCardinality, rightCardinality);
+  }
+  assignFilters();
+}
+
+/*!
+ * Attach each filter to the first pattern, in join order, which binds its variable
+ */
+void JoinPlanner::assignFilters() {
+  for (size_t i = 0; i < patterns.size(); i++) {
+    patterns[i].filters.clear();
+  }
+  for (size_t i = 0; i < filters.size(); i++) {
+    bool assigned = false;
+    for (size_t step = 0; step < order.size() && !assigned; step++) {
+      PatternID &pattern = patterns[order[step]];
+      if (std::find(pattern.vars, pattern.vars + 3, filters[i].getSlot()) != pattern.vars + 3) {
+        pattern.filters.push_back(filters[i]);
+        assigned = true;
+      }
+    }
+  }
+}
+
+/*!
+ * Build the pipeline of operators on top of the scan of the driving pattern
+ * @param  driving      Scan of the driving pattern, owned by the pipeline
+ * @param  memoryBudget Memory budget of each hash join, in bytes
+ * @param  sharedTables For a worker of a parallel join, the hash tables shared
+ *                      by the workers, indexed by join step and created by the
+ *                      first worker. Shared tables are always built over the
+ *                      other patterns, so the driving scan is never materialized.
+ *                      NULL for a pipeline evaluated by a single thread.
+ * @return              The root of the pipeline
+ */
+BindingOperator *JoinPlanner::buildPipeline(BindingOperator *driving,
+                                            size_t memoryBudget,
+                                            std::vector<std::shared_ptr<SharedHashTable>> *sharedTables) {
+  hdt::Triples *triples = hdt->getTriples();
+  size_t nbVars = varNames.size();
+  std::vector<bool> bound(nbVars, false);
+  BindingOperator *root = driving;
+  for (int j = 0; j < 3; j++) {
+    if (patterns[order[0]].vars[j] >= 0) {
+      bound[patterns[order[0]].vars[j]] = true;
+    }
+  }
+  for (size_t step = 1; step < order.size(); step++) {
+    PatternID &pattern = patterns[order[step]];
+    if (useHashJoin[step]) {
+      std::vector<int> keyVars;
+      for (int j = 0; j < 3; j++) {
+        int var = pattern.vars[j];
+        if (var >= 0 && bound[var] && std::find(keyVars.begin(), keyVars.end(), var) == keyVars.end()) {
+          keyVars.push_back(var);
+        }
+      }
+      if (sharedTables != NULL) {
+        std::shared_ptr<SharedHashTable> &table = (*sharedTables)[step];
+        if (!table) {
+          table = std::make_shared<SharedHashTable>(new PatternScan(triples, pattern, mapping, nbVars),
+                                                    keyVars, nbVars);
+        }
+        root = new SharedHashJoin(root, table, nbVars);
+      } else {
+        BindingOperator *scan = new PatternScan(triples, pattern, mapping, nbVars);
+        // build the hash table over the smallest input
+        if (scan->estimatedCardinality() <= root->estimatedCardinality()) {
+          root = new HashJoin(scan, root, keyVars, nbVars, memoryBudget);
+        } else {
+          root = new HashJoin(root, scan, keyVars, nbVars, memoryBudget);
+        }
+      }
+    } else {
+      root = new BindJoin(root, triples, pattern, mapping, cardinalities[order[step]]);
+    }
+    for (int j = 0; j < 3; j++) {
+      if (pattern.vars[j] >= 0) {
+        bound[pattern.vars[j]] = true;
+      }
+    }
+  }
+  return root;
+}
+
+/*!
+ * Build a ParallelJoin, where each worker evaluates the pipeline over a slice
+ * of the driving pattern. If the driving iterator can jump to a position, slices
+ * are ranges of positions: as HDT scans are sorted by IDs, they correspond to
+ * ranges of IDs of the join variable. Otherwise, the driving pattern is read
+ * once, and handed out to the workers in chunks through a SharedScan.
+ * Hash tables are built once and shared by all workers.
+ * Returns NULL if all slices of positions are empty.
+ * @param  memoryBudget Memory budget of all hash joins, in bytes
+ * @param  nbWorkers    Number of worker threads
+ * @param  star         If True, each worker evaluates a StarJoin
+ * @return              The ParallelJoin, or NULL
+ */
+BindingOperator *JoinPlanner::buildParallel(size_t memoryBudget, size_t nbWorkers, bool star) {
+  hdt::Triples *triples = hdt->getTriples();
+  PatternID &driving = patterns[order[0]];
+  size_t nbVars = varNames.size();
+
+  // find the variable used to join the driving pattern with the next one
+  int joinVar = -1;
+  for (int j = 0; j < 3 && joinVar < 0; j++) {
+    for (int k = 0; k < 3; k++) {
+      if (driving.vars[j] >= 0 && driving.vars[j] == patterns[order[1]].vars[k]) {
+        joinVar = driving.vars[j];
+      }
+    }
+  }
+
+  hdt::IteratorTripleID *it = triples->search(driving.ids);
+  bool canSplitPositions = it->canGoTo() && it->numResultEstimation() == hdt::EXACT;
+  size_t nbResults = it->estimatedNumResults();
+  delete it;
+
+  // split positions evenly, then move each boundary after the last triple
+  // with the same join variable, so a join key is never split between workers
+  std::vector<size_t> bounds(nbWorkers + 1, nbResults);
+  std::shared_ptr<SharedScan> sharedScan;
+  if (canSplitPositions) {
+    bounds[0] = 0;
+    for (size_t i = 1; i < nbWorkers; i++) {
+      size_t position = (nbResults * i) / nbWorkers;
+      if (joinVar >= 0) {
+        position = alignPosition(driving, joinVar, position);
+      }
+      bounds[i] = std::max(position, bounds[i - 1]);
+    }
+  } else {
+    sharedScan = std::make_shared<SharedScan>(new PatternScan(triples, driving, mapping, nbVars),
+                                              joinVar, nbVars);
+  }
+
+  std::vector<std::shared_ptr<SharedHashTable>> sharedTables(order.size());
+  std::vector<BindingOperator *> pipelines;
+  for (size_t i = 0; i < nbWorkers; i++) {
+    BindingOperator *scan;
+    if (canSplitPositions) {
+      if (bounds[i] == bounds[i + 1]) {
+        continue;
+      }
+      PatternScan *slice = new PatternScan(triples, driving, mapping, nbVars);
+      slice->restrictPositions(bounds[i], bounds[i + 1] - bounds[i]);
+      scan = slice;
+    } else {
+      scan = new ChunkScan(sharedScan, nbVars);
+    }
+    if (star) {
+      pipelines.push_back(new StarJoin(scan, triples, patterns, mapping, nbVars));
+    } else {
+      pipelines.push_back(buildPipeline(scan, memoryBudget, &sharedTables));
+    }
+  }
+  if (pipelines.empty()) {
+    return NULL;
+  }
+  // same estimation as the join operators: the size of the largest input
+  size_t cardinality = *std::max_element(cardinalities.begin(), cardinalities.end());
+  return new ParallelJoin(pipelines, nbVars, cardinality, PARALLEL_QUEUE_CAPACITY);
+}
+
+/*!
+ * Test if the join is a star: all patterns share the same subject variable,
+ * have a constant predicate, and their objects are constants or variables
+ * which do not appear anywhere else.
+ * @return True if the patterns form a star
+ */
+bool JoinPlanner::isStar() {
+  int subjectVar = patterns[0].vars[0];
+  if (subjectVar < 0 || patterns.size() < 2) {
+    return false;
+  }
+  std::vector<bool> seen(varNames.size(), false);
+  seen[subjectVar] = true;
+  for (size_t i = 0; i < patterns.size(); i++) {
+    int objectVar = patterns[i].vars[2];
+    if (patterns[i].vars[0] != subjectVar || patterns[i].vars[1] >= 0) {
+      return false;
+    }
+    if (objectVar >= 0) {
+      if (seen[objectVar]) {
+        return false;
+      }
+      seen[objectVar] = true;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Find the first position, starting from position, where the join variable
+ * differs from its value at position - 1
+ * @param  pattern  Pattern scanned by the worker
+ * @param  var      Join variable, whose runs of equal values must not be split
+ * @param  position Position of the start of a slice
+ * @return          First position of the aligned slice
+ */
+size_t JoinPlanner::alignPosition(PatternID &pattern, int var, size_t position) {
+  if (position == 0) {
+    return position;
+  }
+  hdt::IteratorTripleID *it = hdt->getTriples()->search(pattern.ids);
+  it->goTo(position - 1);
+  binding_row row(varNames.size(), 0);
+  bindTriple(pattern, *it->next(), mapping, row);
+  size_t value = row[var];
+  while (it->hasNext()) {
+    row.assign(varNames.size(), 0);
+    bindTriple(pattern, *it->next(), mapping, row);
+    if (row[var] != value) {
+      break;
+    }
+    position++;
+  }
+  delete it;
+  return position;
+}
+
+BindingOperator *JoinPlanner::plan(size_t memoryBudget, int threads,
+                                   size_t limit, size_t offset) {
+  bool sliced = limit > 0 || offset > 0;
+  bool filtered = filters.size() > 0;
+  if (!supported || (patterns.size() < 2 && !sliced && !filtered)) {
+    return NULL;
+  }
+  bool star = isStar();
+  size_t nbWorkers = resolveThreads(threads);
+  size_t drivingCardinality = *std::min_element(cardinalities.begin(), cardinalities.end());
+  // with a limit or an offset, solutions must come in a stable order
+  if (!sliced && patterns.size() > 1 && nbWorkers > 1 && drivingCardinality >= parallelMinCardinality) {
+    orderPatterns(nbWorkers, memoryBudget, true);
+    BindingOperator *parallel = buildParallel(memoryBudget, nbWorkers, star);
+    if (parallel != NULL) {
+      return parallel;
+    }
+  }
+
+  // with a limit, avoid hash joins, which read their build input entirely
+  // before producing the first solution. Offsets use the same plan, so that
+  // pages of solutions are consistent with each other.
+  orderPatterns(1, memoryBudget, !sliced);
+  PatternScan *driving = new PatternScan(hdt->getTriples(), patterns[order[0]], mapping, varNames.size());
+  BindingOperator *root;
+  if (star) {
+    root = new StarJoin(driving, hdt->getTriples(), patterns, mapping, varNames.size());
+  } else if (sliced || filtered || std::find(useHashJoin.begin(), useHashJoin.end(), true) != useHashJoin.end()) {
+    root = buildPipeline(driving, memoryBudget, NULL);
+  } else {
+    // without hash joins nor filters, the QueryProcessor already does the job
+    delete driving;
+    return NULL;
+  }
+  if (sliced) {
+    root = new SliceOperator(root, limit, offset);
+  }
+  return root;
+}
+
+void JoinPlanner::setHashJoinMinCardinality(size_t cardinality) {
+  hashJoinMinCardinality = cardinality;
+}
+
+void JoinPlanner::setParallelMinCardinality(size_t cardinality) {
+  parallelMinCardinality = cardinality;
+}
+
+std::vector<std::string> JoinPlanner::getVarNames() { return varNames; }
+
+std::vector<hdt::TripleComponentRole> JoinPlanner::getVarRoles() { return varRoles; }
+
+GlobalIDMapping JoinPlanner::getMapping() { return mapping; }
+
+std::vector<TermFilter> JoinPlanner::getFilters() { return filters; }
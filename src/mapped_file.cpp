@@ -0,0 +1,85 @@
+/**
+ * mapped_file.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "mapped_file.hpp"
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// mappings of this process, indexed by path
+static std::map<std::string, std::weak_ptr<MappedFile>> openedFiles;
+static std::mutex openedFilesMutex;
+
+MappedFile::MappedFile(std::string _path) : path(_path), data(NULL), size(0) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open file '" + path + "'");
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw std::runtime_error("Cannot open file '" + path + "'");
+  }
+  size = info.st_size;
+  device = info.st_dev;
+  inode = info.st_ino;
+  // mmap rejects empty mappings
+  if (size > 0) {
+    data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    data = NULL;
+    throw std::runtime_error("Cannot map file '" + path + "' in memory");
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data != NULL) {
+    munmap(data, size);
+  }
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(std::string path) {
+  std::lock_guard<std::mutex> lock(openedFilesMutex);
+  std::shared_ptr<MappedFile> file = openedFiles[path].lock();
+  struct stat info;
+  bool replaced = stat(path.c_str(), &info) != 0 ||
+                  (unsigned long long) info.st_dev != (file ? file->device : 0) ||
+                  (unsigned long long) info.st_ino != (file ? file->inode : 0);
+  if (!file || replaced) {
+    file = std::make_shared<MappedFile>(path);
+    openedFiles[path] = file;
+  }
+  return file;
+}
+
+void MappedFile::write(std::string path, const std::vector<std::pair<const void *, size_t>> &chunks) {
+  std::string tmpPath = path + ".tmp" + std::to_string(getpid());
+  std::ofstream output(tmpPath.c_str(), std::ios::binary);
+  if (!output.is_open()) {
+    throw std::runtime_error("Cannot write file '" + tmpPath + "'");
+  }
+  for (size_t i = 0; i < chunks.size(); i++) {
+    output.write((const char *) chunks[i].first, chunks[i].second);
+  }
+  output.close();
+  if (output.fail() || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    remove(tmpPath.c_str());
+    throw std::runtime_error("Cannot write file '" + path + "'");
+  }
+}
+
+std::string MappedFile::getPath() const { return path; }
+
+const char *MappedFile::getData() const { return (const char *) data; }
+
+size_t MappedFile::getSize() const { return size; }
@@ -0,0 +1,115 @@
+/**
+ * propagation.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "propagation.hpp"
+#include "thread_utils.hpp"
+#include <algorithm>
+#include <cmath>
+
+PropagationGraph::PropagationGraph(size_t _nbNodes, std::vector<unsigned int> &predicates,
+                                   std::vector<std::vector<unsigned int>> &rows,
+                                   std::vector<std::vector<unsigned int>> &cols,
+                                   std::map<unsigned int, double> &predicateWeights,
+                                   double defaultWeight)
+    : nbNodes(_nbNodes), indptr(_nbNodes + 1, 0), strengths(_nbNodes, 0) {
+  std::vector<double> edgeWeights(predicates.size(), defaultWeight);
+  for (size_t i = 0; i < predicates.size(); i++) {
+    auto found = predicateWeights.find(predicates[i]);
+    if (found != predicateWeights.end()) {
+      edgeWeights[i] = found->second;
+    }
+  }
+  // the predicate matrices are merged in a single CSR matrix, so a product
+  // reads each row once. Edges are stored in both directions.
+  for (size_t i = 0; i < predicates.size(); i++) {
+    if (edgeWeights[i] == 0) {
+      continue;
+    }
+    for (size_t j = 0; j < rows[i].size(); j++) {
+      indptr[rows[i][j] + 1]++;
+      indptr[cols[i][j] + 1]++;
+    }
+  }
+  for (size_t v = 0; v < nbNodes; v++) {
+    indptr[v + 1] += indptr[v];
+  }
+  indices.resize(indptr[nbNodes]);
+  weights.resize(indptr[nbNodes]);
+  std::vector<uint64_t> next(indptr.begin(), indptr.end() - 1);
+  for (size_t i = 0; i < predicates.size(); i++) {
+    if (edgeWeights[i] == 0) {
+      continue;
+    }
+    for (size_t j = 0; j < rows[i].size(); j++) {
+      unsigned int u = rows[i][j], v = cols[i][j];
+      indices[next[u]] = v;
+      weights[next[u]++] = edgeWeights[i];
+      indices[next[v]] = u;
+      weights[next[v]++] = edgeWeights[i];
+      strengths[u] += edgeWeights[i];
+      strengths[v] += edgeWeights[i];
+    }
+  }
+}
+
+void PropagationGraph::multiply(const std::vector<double> &x, std::vector<double> &y,
+                                bool normalized, size_t nbThreads) const {
+  y.assign(nbNodes, 0);
+  // each thread computes a range of rows, so no write is shared
+  parallelFor(nbNodes, nbThreads, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      double sum = 0;
+      for (uint64_t e = indptr[v]; e < indptr[v + 1]; e++) {
+        unsigned int u = indices[e];
+        if (!normalized) {
+          sum += weights[e] * x[u];
+        } else if (strengths[u] != 0) {
+          sum += weights[e] * x[u] / strengths[u];
+        }
+      }
+      y[v] = sum;
+    }
+  });
+}
+
+std::vector<double> PropagationGraph::spread(std::vector<double> seeds, size_t iterations,
+                                             size_t nbThreads) const {
+  std::vector<double> activations = seeds, next;
+  for (size_t i = 0; i < iterations; i++) {
+    multiply(activations, next, false, nbThreads);
+    double maxActivation = 0;
+    for (size_t v = 0; v < nbNodes; v++) {
+      maxActivation = std::max(maxActivation, std::abs(next[v]));
+    }
+    if (maxActivation > 0) {
+      for (size_t v = 0; v < nbNodes; v++) {
+        next[v] /= maxActivation;
+      }
+    }
+    activations.swap(next);
+  }
+  return activations;
+}
+
+std::vector<double> PropagationGraph::personalizedPageRank(const std::vector<double> &seeds,
+                                                           size_t iterations, double alpha,
+                                                           size_t nbThreads) const {
+  std::vector<double> ranks = seeds, next;
+  for (size_t i = 0; i < iterations; i++) {
+    multiply(ranks, next, true, nbThreads);
+    // nodes without any edge give their rank back to the seeds
+    double dangling = 0;
+    for (size_t v = 0; v < nbNodes; v++) {
+      if (strengths[v] == 0) {
+        dangling += ranks[v];
+      }
+    }
+    for (size_t v = 0; v < nbNodes; v++) {
+      next[v] = alpha * seeds[v] + (1 - alpha) * (next[v] + dangling * seeds[v]);
+    }
+    ranks.swap(next);
+  }
+  return ranks;
+}
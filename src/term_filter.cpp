@@ -0,0 +1,190 @@
+/**
+ * term_filter.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "term_filter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+/*!
+ * Get the index of a role in the per-role arrays
+ * @param  role Role of a term
+ * @return      Index of the role, in [0, 3)
+ */
+inline int roleIndex(hdt::TripleComponentRole role) {
+  if (role == hdt::SUBJECT) {
+    return 0;
+  } else if (role == hdt::PREDICATE) {
+    return 1;
+  }
+  return 2;
+}
+
+inline bool startsWith(const std::string &term, const std::string &prefix) {
+  return term.compare(0, prefix.size(), prefix) == 0;
+}
+
+/*!
+ * Find the first ID in [first, last) whose term starts with prefix, or sorts
+ * after it if beforeOnly is False. IDs of a dictionary section are sorted by
+ * their terms, so a binary search only decodes a few terms.
+ * @param  dict       Dictionary of the HDT document
+ * @param  role       Role of the terms, which selects the dictionary section
+ * @param  first      First ID of the searched range
+ * @param  last       ID following the searched range
+ * @param  prefix     Prefix searched
+ * @param  beforeOnly If True, skip only the terms sorted before prefix,
+ *                    otherwise also skip the terms starting with prefix
+ * @return            First ID which is not skipped, or last
+ */
+static size_t lowerBound(hdt::Dictionary *dict, hdt::TripleComponentRole role,
+                         size_t first, size_t last, const std::string &prefix,
+                         bool beforeOnly) {
+  while (first < last) {
+    size_t middle = first + (last - first) / 2;
+    std::string term = dict->idToString(middle, role);
+    bool skip = term.compare(prefix) < 0 || (!beforeOnly && startsWith(term, prefix));
+    if (skip) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return first;
+}
+
+/*!
+ * Get the range of IDs of [first, last) whose terms start with a prefix
+ * @param  dict   Dictionary of the HDT document
+ * @param  role   Role of the terms, which selects the dictionary section
+ * @param  first  First ID of the searched range
+ * @param  last   ID following the searched range
+ * @param  prefix Prefix searched
+ * @return        Range of IDs, empty if no term starts with prefix
+ */
+static id_range prefixRange(hdt::Dictionary *dict, hdt::TripleComponentRole role,
+                            size_t first, size_t last, const std::string &prefix) {
+  size_t low = lowerBound(dict, role, first, last, prefix, true);
+  return id_range(low, lowerBound(dict, role, low, last, prefix, false));
+}
+
+/*!
+ * Constructor
+ * @param _dict Dictionary used to compile the filter
+ * @param expr  Filter expression, as (target, operator) or (target, operator, argument)
+ * @param _slot Triple position or join variable filtered
+ */
+TermFilter::TermFilter(hdt::Dictionary *_dict, filter_expr expr, int _slot)
+    : dictionary(_dict), slot(_slot) {
+  if (expr.size() < 2 || expr.size() > 3) {
+    throw std::runtime_error("A filter must be a tuple (target, operator) or (target, operator, argument)");
+  }
+  target = expr[0];
+  op = expr[1];
+  arg = (expr.size() == 3) ? expr[2] : "";
+  if (op != "iri" && op != "literal" && op != "prefix" && op != "lang") {
+    throw std::runtime_error("Unknown filter operator '" + op + "'");
+  }
+
+  // each dictionary section is sorted independently
+  size_t nbShared = dictionary->getNshared();
+  compileRanges(hdt::SUBJECT, 1, nbShared + 1);
+  compileRanges(hdt::SUBJECT, nbShared + 1, dictionary->getMaxSubjectID() + 1);
+  compileRanges(hdt::PREDICATE, 1, dictionary->getNpredicates() + 1);
+  compileRanges(hdt::OBJECT, 1, nbShared + 1);
+  compileRanges(hdt::OBJECT, nbShared + 1, dictionary->getMaxObjectID() + 1);
+}
+
+/*!
+ * Add the ranges of IDs of the literals of a section which pass a "lang" filter,
+ * by decoding each literal of the section once
+ * @param accepted Accepted ranges of the role, where the ranges are added
+ * @param role     Role of the terms, which selects the dictionary section
+ * @param literals Range of IDs of the literals of the section
+ */
+void TermFilter::compileLiterals(std::vector<id_range> &accepted,
+                                 hdt::TripleComponentRole role, id_range literals) {
+  size_t runStart = literals.first;
+  for (size_t id = literals.first; id <= literals.second; id++) {
+    bool pass = id < literals.second && acceptsTerm(dictionary->idToString(id, role));
+    if (!pass) {
+      if (runStart < id) {
+        accepted.push_back(id_range(runStart, id));
+      }
+      runStart = id + 1;
+    }
+  }
+}
+
+/*!
+ * Add the ranges of IDs accepted by the filter in the section [first, last)
+ * @param role  Role of the terms, which selects the dictionary section
+ * @param first First ID of the section
+ * @param last  ID following the section
+ */
+void TermFilter::compileRanges(hdt::TripleComponentRole role, size_t first, size_t last) {
+  std::vector<id_range> &accepted = ranges[roleIndex(role)];
+  if (first >= last) {
+    return;
+  }
+  if (op == "prefix") {
+    accepted.push_back(prefixRange(dictionary, role, first, last, arg));
+  } else if (op == "literal") {
+    accepted.push_back(prefixRange(dictionary, role, first, last, "\""));
+  } else if (op == "lang") {
+    compileLiterals(accepted, role, prefixRange(dictionary, role, first, last, "\""));
+  } else {
+    // IRIs are the terms which are neither literals nor blank nodes
+    id_range literals = prefixRange(dictionary, role, first, last, "\"");
+    id_range blanks = prefixRange(dictionary, role, first, last, "_:");
+    std::vector<id_range> excluded = {literals, blanks};
+    std::sort(excluded.begin(), excluded.end());
+    size_t low = first;
+    for (size_t i = 0; i < excluded.size(); i++) {
+      if (excluded[i].first > low) {
+        accepted.push_back(id_range(low, excluded[i].first));
+      }
+      low = std::max(low, excluded[i].second);
+    }
+    accepted.push_back(id_range(low, last));
+  }
+}
+
+std::string TermFilter::getTarget() const { return target; }
+
+int TermFilter::getSlot() const { return slot; }
+
+bool TermFilter::accepts(size_t id, hdt::TripleComponentRole role) const {
+  const std::vector<id_range> &accepted = ranges[roleIndex(role)];
+  // find the last range starting at or before id
+  auto range = std::upper_bound(accepted.begin(), accepted.end(), id,
+                                [](size_t value, const id_range &r) { return value < r.first; });
+  return range != accepted.begin() && id < (range - 1)->second;
+}
+
+bool TermFilter::acceptsTerm(const std::string &term) const {
+  bool isLiteral = term.size() > 0 && term[0] == '"';
+  if (op == "prefix") {
+    return startsWith(term, arg);
+  } else if (op == "literal") {
+    return isLiteral;
+  } else if (op == "iri") {
+    return !isLiteral && !startsWith(term, "_:");
+  }
+  // language tags follow the closing quote of the literal, e.g., "chat"@fr
+  size_t quote = term.rfind('"');
+  if (!isLiteral || quote == 0 || quote + 1 >= term.size() || term[quote + 1] != '@') {
+    return false;
+  }
+  std::string lang = term.substr(quote + 2);
+  if (arg.empty()) {
+    return true;
+  }
+  // language tags are case-insensitive
+  return lang.size() == arg.size() &&
+         std::equal(lang.begin(), lang.end(), arg.begin(), [](char a, char b) {
+           return std::tolower(a) == std::tolower(b);
+         });
+}
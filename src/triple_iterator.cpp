@@ -7,18 +7,105 @@
 #include <HDTEnums.hpp>
 #include <SingleTriple.hpp>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 /*!
  * Constructor
- * @param iterator [description]
+ * @param iterator     [description]
+ * @param _dict        [description]
+ * @param _decodeMutex Lock held while decoding triples
  */
-TripleIterator::TripleIterator(TripleIDIterator *_it, hdt::Dictionary *_dict)
-    : iterator(_it), dictionary(_dict) {};
+TripleIterator::TripleIterator(TripleIDIterator *_it, hdt::Dictionary *_dict,
+                               std::shared_ptr<std::mutex> _decodeMutex)
+    : iterator(_it), dictionary(_dict), decodeMutex(_decodeMutex), buffer(NULL),
+      hasBufferedTriple(false), ended(false), resultsRead(0), raw(false) {};
+
+/*!
+ * Constructor, for an iterator which may prefetch triples in a background
+ * thread, or return raw RDF terms
+ * @param iterator     [description]
+ * @param _dict        [description]
+ * @param _decodeMutex Lock held while decoding triples
+ * @param prefetch     Maximum number of decoded triples waiting to be consumed, 0 to disable prefetching
+ * @param _raw         If True, RDF terms are returned to Python as bytes
+ */
+TripleIterator::TripleIterator(TripleIDIterator *_it, hdt::Dictionary *_dict,
+                               std::shared_ptr<std::mutex> _decodeMutex,
+                               size_t prefetch, bool _raw)
+    : TripleIterator(_it, _dict, _decodeMutex) {
+  raw = _raw;
+  if (prefetch > 0) {
+    // the ID iterator belongs to the producer from now on
+    hint = iterator->sizeHint();
+    buffer = new RingBuffer<triple>(prefetch);
+    producer = std::thread(&TripleIterator::runProducer, this);
+  }
+}
 
 /*!
  * Destructor
  */
-TripleIterator::~TripleIterator() { delete iterator; };
+TripleIterator::~TripleIterator() {
+  if (buffer != NULL) {
+    // stop the producer if the iterator is dropped before its end
+    buffer->cancel();
+    producer.join();
+    delete buffer;
+  }
+  delete iterator;
+};
+
+/*!
+ * Scan and decode triples into the ring buffer, until the end of the
+ * iterator or until the consumer cancels the buffer
+ */
+void TripleIterator::runProducer() {
+  try {
+    bool cancelled = false;
+    while (!cancelled && iterator->hasNext()) {
+      triple_id t = iterator->next();
+      triple decoded;
+      {
+        std::lock_guard<std::mutex> lock(*decodeMutex);
+        decoded = decode(t);
+      }
+      cancelled = !buffer->push(decoded);
+    }
+  } catch (...) {
+    // reported to the consumer once the buffer is drained
+    error = std::current_exception();
+  }
+  buffer->close();
+}
+
+/*!
+ * Decode a triple of IDs into RDF terms. Sections of the dictionary decode
+ * terms lazily and are not thread-safe, so decodeMutex must be held.
+ * @param  t Triple of IDs
+ * @return   Triple of RDF terms
+ */
+triple TripleIterator::decode(const triple_id &t) {
+  return std::make_tuple(
+    dictionary->idToString(std::get<0>(t), hdt::SUBJECT),
+    dictionary->idToString(std::get<1>(t), hdt::PREDICATE),
+    dictionary->idToString(std::get<2>(t), hdt::OBJECT));
+}
+
+/*!
+ * Read the next prefetched triple into bufferedTriple.
+ * Returns False if the iterator has ended.
+ * @return True if bufferedTriple holds a triple
+ */
+bool TripleIterator::fetchNext() {
+  if (!hasBufferedTriple && !ended) {
+    hasBufferedTriple = buffer->pop(bufferedTriple);
+    ended = !hasBufferedTriple;
+    if (ended && error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return hasBufferedTriple;
+}
 
 /*!
  * Implementation for Python function "__repr__"
@@ -76,7 +163,13 @@ unsigned int TripleIterator::getOffset() { return iterator->getOffset(); }
  * Get the number of results read by the iterator
  * @return [description]
  */
-unsigned int TripleIterator::getNbResultsRead() { return iterator->getNbResultsRead(); }
+unsigned int TripleIterator::getNbResultsRead() {
+  // the producer reads ahead of the consumer
+  if (buffer != NULL) {
+    return resultsRead;
+  }
+  return iterator->getNbResultsRead();
+}
 
 /*!
  * Implementation for Python function "__iter__"
@@ -90,6 +183,9 @@ TripleIterator *TripleIterator::python_iter() { return this; }
  * @return [description]
  */
 size_hint TripleIterator::sizeHint() {
+  if (buffer != NULL) {
+    return hint;
+  }
   return iterator->sizeHint();
 }
 
@@ -98,6 +194,9 @@ size_hint TripleIterator::sizeHint() {
  * @return [description]
  */
 bool TripleIterator::hasNext() {
+  if (buffer != NULL) {
+    return fetchNext();
+  }
   return iterator->hasNext();
 }
 
@@ -107,11 +206,42 @@ bool TripleIterator::hasNext() {
  * @return [description]
  */
 triple TripleIterator::next() {
+  if (buffer != NULL) {
+    if (!fetchNext()) {
+      throw pybind11::stop_iteration();
+    }
+    hasBufferedTriple = false;
+    resultsRead++;
+    return bufferedTriple;
+  }
   triple_id t = iterator->next();
-  return std::make_tuple(
-    dictionary->idToString(std::get<0>(t), hdt::SUBJECT),
-    dictionary->idToString(std::get<1>(t), hdt::PREDICATE),
-    dictionary->idToString(std::get<2>(t), hdt::OBJECT));
+  std::lock_guard<std::mutex> lock(*decodeMutex);
+  return decode(t);
+}
+
+/**
+ * Get up to n items from the iterator, or nothing if the iterator has ended
+ * @param  n Maximum number of items
+ * @return   Items read, fewer than n at the end of the iterator
+ */
+std::vector<triple> TripleIterator::nextBatch(size_t n) {
+  std::vector<triple> batch;
+  if (buffer != NULL) {
+    for (size_t i = 0; i < n && hasNext(); i++) {
+      batch.push_back(next());
+    }
+    return batch;
+  }
+  // read the IDs first, so the dictionary is locked once per batch
+  std::vector<triple_id> ids;
+  for (size_t i = 0; i < n && iterator->hasNext(); i++) {
+    ids.push_back(iterator->next());
+  }
+  std::lock_guard<std::mutex> lock(*decodeMutex);
+  for (auto it = ids.begin(); it != ids.end(); it++) {
+    batch.push_back(decode(*it));
+  }
+  return batch;
 }
 
 /**
@@ -120,9 +250,84 @@ triple TripleIterator::next() {
  * @return [description]
  */
 triple TripleIterator::peek() {
+  if (buffer != NULL) {
+    if (!fetchNext()) {
+      throw pybind11::stop_iteration();
+    }
+    return bufferedTriple;
+  }
   triple_id t = iterator->peek();
-  return std::make_tuple(
-    dictionary->idToString(std::get<0>(t), hdt::SUBJECT),
-    dictionary->idToString(std::get<1>(t), hdt::PREDICATE),
-    dictionary->idToString(std::get<2>(t), hdt::OBJECT));
+  std::lock_guard<std::mutex> lock(*decodeMutex);
+  return decode(t);
+}
+
+/*!
+ * Convert a triple to Python, as a tuple of str, or of bytes in raw mode
+ * @param  t Triple of RDF terms
+ * @return   Tuple of str, or of bytes in raw mode
+ */
+py::object TripleIterator::toPython(const triple &t) {
+  if (raw) {
+    return py::make_tuple(py::bytes(std::get<0>(t)), py::bytes(std::get<1>(t)),
+                          py::bytes(std::get<2>(t)));
+  }
+  return py::cast(t);
+}
+
+/*!
+ * Implementation for Python function "__next__"
+ * @return Next triple, as a tuple of str, or of bytes in raw mode
+ */
+py::object TripleIterator::python_next() {
+  triple t;
+  {
+    py::gil_scoped_release release;
+    t = next();
+  }
+  return toPython(t);
+}
+
+/*!
+ * Implementation for Python function "peek"
+ * @return Next triple, as a tuple of str, or of bytes in raw mode
+ */
+py::object TripleIterator::python_peek() {
+  triple t;
+  {
+    py::gil_scoped_release release;
+    t = peek();
+  }
+  return toPython(t);
+}
+
+/*!
+ * Implementation for Python function "next_batch"
+ * @param  n Maximum number of triples
+ * @return   List of triples, or a tuple (buffer, offsets) in raw mode
+ */
+py::object TripleIterator::python_nextBatch(size_t n) {
+  if (!raw) {
+    std::vector<triple> batch;
+    {
+      py::gil_scoped_release release;
+      batch = nextBatch(n);
+    }
+    return py::cast(batch);
+  }
+  // pack all terms into a single buffer, copied once into a bytes object
+  std::string buffer;
+  std::vector<uint64_t> offsets(1, 0);
+  {
+    py::gil_scoped_release release;
+    std::vector<triple> batch = nextBatch(n);
+    for (auto t = batch.begin(); t != batch.end(); t++) {
+      buffer += std::get<0>(*t);
+      offsets.push_back(buffer.size());
+      buffer += std::get<1>(*t);
+      offsets.push_back(buffer.size());
+      buffer += std::get<2>(*t);
+      offsets.push_back(buffer.size());
+    }
+  }
+  return py::make_tuple(py::bytes(buffer), toArray(std::move(offsets)));
 }
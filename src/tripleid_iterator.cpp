@@ -7,6 +7,7 @@
 #include <HDTEnums.hpp>
 #include <SingleTriple.hpp>
 #include <pybind11/pybind11.h>
+#include <algorithm>
 
 /*!
  * Constructor
@@ -21,6 +22,23 @@ TripleIDIterator::TripleIDIterator(hdt::IteratorTripleID *_it,
       object((_obj.compare("") == 0) ? "?o" : _obj), limit(_limit),
       offset(_offset), iterator(_it){};
 
+/*!
+ * Constructor, for an iterator which only returns the triples passing a set of filters
+ * @param iterator HDT iterator over the triples matching the pattern, filtered by _filters
+ */
+TripleIDIterator::TripleIDIterator(hdt::IteratorTripleID *_it,
+                                   std::string _subj, std::string _pred,
+                                   std::string _obj, unsigned int _limit,
+                                   unsigned int _offset,
+                                   std::vector<TermFilter> _filters)
+    : TripleIDIterator(_it, _subj, _pred, _obj, _limit, _offset) {
+  filters = _filters;
+  // skip the first triples passing the filters
+  for (unsigned int i = 0; i < offset && iterator->hasNext(); i++) {
+    while (iterator->hasNext() && !acceptsTriple(*iterator->next())) {}
+  }
+}
+
 /*!
  * Destructor
  */
@@ -96,7 +114,25 @@ TripleIDIterator *TripleIDIterator::python_iter() { return this; }
  * @return [description]
  */
 size_hint TripleIDIterator::sizeHint() {
-  return std::make_tuple(iterator->estimatedNumResults(), iterator->numResultEstimation() == hdt::EXACT);
+  bool exact = iterator->numResultEstimation() == hdt::EXACT && filters.empty();
+  return std::make_tuple(iterator->estimatedNumResults(), exact);
+}
+
+/*!
+ * Test if a triple passes all filters
+ * @param  triple Triple of IDs
+ * @return        True if the triple passes all filters
+ */
+bool TripleIDIterator::acceptsTriple(const hdt::TripleID &triple) {
+  const hdt::TripleComponentRole roles[3] = {hdt::SUBJECT, hdt::PREDICATE, hdt::OBJECT};
+  const size_t ids[3] = {triple.getSubject(), triple.getPredicate(), triple.getObject()};
+  for (size_t i = 0; i < filters.size(); i++) {
+    int position = filters[i].getSlot();
+    if (!filters[i].accepts(ids[position], roles[position])) {
+      return false;
+    }
+  }
+  return true;
 }
 
 /*!
@@ -105,7 +141,19 @@ size_hint TripleIDIterator::sizeHint() {
  */
 bool TripleIDIterator::hasNext() {
   bool noLimit = limit == 0;
-  return iterator->hasNext() && (noLimit || limit > resultsRead);
+  if (filters.empty() || hasBufferedTriple || !(noLimit || limit > resultsRead)) {
+    return (hasBufferedTriple || iterator->hasNext()) && (noLimit || limit > resultsRead);
+  }
+  // look for the next triple passing the filters, and buffer it
+  while (iterator->hasNext()) {
+    hdt::TripleID *ts = iterator->next();
+    if (acceptsTriple(*ts)) {
+      _bufferedTriple = std::make_tuple(ts->getSubject(), ts->getPredicate(), ts->getObject());
+      hasBufferedTriple = true;
+      return true;
+    }
+  }
+  return false;
 }
 
 /**
@@ -121,15 +169,37 @@ triple_id TripleIDIterator::next() {
     return _bufferedTriple;
   }
   bool noLimit = limit == 0;
-  if (iterator->hasNext() && (noLimit || limit > resultsRead)) {
-    resultsRead++;
+  while (iterator->hasNext() && (noLimit || limit > resultsRead)) {
     hdt::TripleID *ts = iterator->next();
-    return std::make_tuple(ts->getSubject(), ts->getPredicate(),
-                           ts->getObject());
+    if (filters.empty() || acceptsTriple(*ts)) {
+      resultsRead++;
+      return std::make_tuple(ts->getSubject(), ts->getPredicate(),
+                             ts->getObject());
+    }
   }
   throw pybind11::stop_iteration();
 }
 
+/**
+ * Get up to n items from the iterator, as an array of shape (k, 3), k <= n
+ * @param  n Maximum number of items
+ * @return   Items read, fewer than n at the end of the iterator
+ */
+py::array_t<unsigned int> TripleIDIterator::nextBatch(size_t n) {
+  std::vector<unsigned int> batch;
+  {
+    py::gil_scoped_release release;
+    batch.reserve(3 * std::min(n, (size_t) 4096));
+    for (size_t i = 0; i < n && hasNext(); i++) {
+      triple_id t = next();
+      batch.push_back(std::get<0>(t));
+      batch.push_back(std::get<1>(t));
+      batch.push_back(std::get<2>(t));
+    }
+  }
+  return toArray(std::move(batch), 3);
+}
+
 /**
  * Get the next item in the iterator, or raise py::StopIteration if the iterator
  * has ended, but without advancing the iterator.
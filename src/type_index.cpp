@@ -0,0 +1,216 @@
+/**
+ * type_index.cpp
+ * Author: pyHDT contributors - MIT License
+ */
+
+#include "type_index.hpp"
+#include "thread_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+using namespace hdt;
+
+// Magic number and version of the file format
+static const char TYPE_INDEX_MAGIC[8] = {'P', 'Y', 'H', 'D', 'T', 'T', 'Y', '1'};
+
+/*
+ * Layout of an index file, where all integers are in native byte order:
+ *   magic (8 bytes)
+ *   nbTriples, nbSubjects, nbObjects, nbPredicates, nbPairs, hdtFileSize, hdtFileTime (uint64)
+ *   predicates (nbPredicates x uint64)
+ *   typesIndptr (nbSubjects + 2 x uint64), entitiesIndptr (nbObjects + 2 x uint64)
+ *   types (nbPairs x uint32), entities (nbPairs x uint32)
+ */
+struct TypeIndexHeader {
+  char magic[8];
+  uint64_t nbTriples;
+  uint64_t nbSubjects;
+  uint64_t nbObjects;
+  uint64_t nbPredicates;
+  uint64_t nbPairs;
+  // size and modification time of the HDT file, or 0 if unknown
+  uint64_t hdtFileSize;
+  uint64_t hdtFileTime;
+};
+
+/*!
+ * Get the size and modification time of a file, left unchanged if the file is unknown
+ * @param path Path of the file, or empty
+ * @param size Output: size of the file
+ * @param time Output: modification time of the file
+ */
+static void statFile(const std::string &path, uint64_t &size, uint64_t &time) {
+  struct stat info;
+  if (!path.empty() && stat(path.c_str(), &info) == 0) {
+    size = info.st_size;
+    time = info.st_mtime;
+  }
+}
+
+/*!
+ * Read the (subject, object) pairs of the triples of a predicate in the
+ * positions [begin, end) of the triples matching (?, predicate, ?)
+ * @param hdt       HDT document
+ * @param predicate ID of the type predicate
+ * @param begin     First position read
+ * @param end       Position after the last position read
+ * @param pairs     Output: the (subject, object) pairs
+ */
+static void readPairs(HDT *hdt, size_t predicate, size_t begin, size_t end,
+                      std::vector<std::pair<uint32_t, uint32_t>> &pairs) {
+  TripleID pattern(0, predicate, 0);
+  IteratorTripleID *it = hdt->getTriples()->search(pattern);
+  if (begin > 0) {
+    it->goTo(begin);
+  }
+  for (size_t i = begin; i < end && it->hasNext(); i++) {
+    TripleID *triple = it->next();
+    pairs.push_back(std::make_pair(triple->getSubject(), triple->getObject()));
+  }
+  delete it;
+}
+
+/*!
+ * Build the offsets of a CSR matrix from the sorted rows of its entries
+ * @param rows   Sorted row of each entry
+ * @param nbRows Number of rows, whose IDs start at 1
+ * @param indptr Output: offsets of the rows, with nbRows + 2 entries
+ */
+static void buildIndptr(std::vector<uint32_t> &rows, size_t nbRows, std::vector<uint64_t> &indptr) {
+  indptr.assign(nbRows + 2, 0);
+  for (size_t i = 0; i < rows.size(); i++) {
+    indptr[rows[i] + 1]++;
+  }
+  for (size_t i = 0; i + 1 < indptr.size(); i++) {
+    indptr[i + 1] += indptr[i];
+  }
+}
+
+void TypeIndex::build(HDT *hdt, std::string hdtFile, std::vector<size_t> predicates,
+                      std::string path, size_t nbThreads) {
+  std::sort(predicates.begin(), predicates.end());
+  predicates.erase(std::unique(predicates.begin(), predicates.end()), predicates.end());
+  std::vector<std::pair<uint32_t, uint32_t>> pairs;
+  for (size_t p = 0; p < predicates.size(); p++) {
+    TripleID pattern(0, predicates[p], 0);
+    IteratorTripleID *it = hdt->getTriples()->search(pattern);
+    bool canSplit = it->canGoTo() && it->numResultEstimation() == EXACT;
+    size_t nbResults = it->estimatedNumResults();
+    delete it;
+    // the triples of the predicate are split by position between threads
+    size_t nbChunks = canSplit ? std::max((size_t) 1, nbThreads) : 1;
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> chunks(nbChunks);
+    parallelFor(nbChunks, nbChunks, [&](size_t begin, size_t end) {
+      for (size_t c = begin; c < end; c++) {
+        size_t first = (nbResults * c) / nbChunks;
+        size_t last = canSplit ? (nbResults * (c + 1)) / nbChunks : (size_t) -1;
+        readPairs(hdt, predicates[p], first, last, chunks[c]);
+      }
+    });
+    for (size_t c = 0; c < nbChunks; c++) {
+      pairs.insert(pairs.end(), chunks[c].begin(), chunks[c].end());
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+  Dictionary *dict = hdt->getDictionary();
+  TypeIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TYPE_INDEX_MAGIC, sizeof(header.magic));
+  header.nbTriples = hdt->getTriples()->getNumberOfElements();
+  header.nbSubjects = dict->getMaxSubjectID();
+  header.nbObjects = dict->getMaxObjectID();
+  header.nbPredicates = predicates.size();
+  header.nbPairs = pairs.size();
+  statFile(hdtFile, header.hdtFileSize, header.hdtFileTime);
+
+  // pairs are sorted by subject, then by object
+  std::vector<uint32_t> subjects, objects;
+  for (size_t i = 0; i < pairs.size(); i++) {
+    subjects.push_back(pairs[i].first);
+    objects.push_back(pairs[i].second);
+  }
+  std::vector<uint64_t> typesIndptr, entitiesIndptr;
+  buildIndptr(subjects, header.nbSubjects, typesIndptr);
+  std::vector<uint32_t> types(objects);
+  // sort by object, then by subject, for the reverse index
+  std::sort(pairs.begin(), pairs.end(), [](const std::pair<uint32_t, uint32_t> &a,
+                                            const std::pair<uint32_t, uint32_t> &b) {
+    return a.second < b.second || (a.second == b.second && a.first < b.first);
+  });
+  for (size_t i = 0; i < pairs.size(); i++) {
+    subjects[i] = pairs[i].first;
+    objects[i] = pairs[i].second;
+  }
+  buildIndptr(objects, header.nbObjects, entitiesIndptr);
+
+  std::vector<uint64_t> predicateIDs(predicates.begin(), predicates.end());
+  std::vector<std::pair<const void *, size_t>> chunks = {
+      {&header, sizeof(header)},
+      {predicateIDs.data(), predicateIDs.size() * sizeof(uint64_t)},
+      {typesIndptr.data(), typesIndptr.size() * sizeof(uint64_t)},
+      {entitiesIndptr.data(), entitiesIndptr.size() * sizeof(uint64_t)},
+      {types.data(), types.size() * sizeof(uint32_t)},
+      {subjects.data(), subjects.size() * sizeof(uint32_t)}};
+  MappedFile::write(path, chunks);
+}
+
+TypeIndex::TypeIndex(std::string path) : file(MappedFile::open(path)) {
+  const TypeIndexHeader *header = (const TypeIndexHeader *) file->getData();
+  if (file->getSize() < sizeof(TypeIndexHeader) ||
+      memcmp(header->magic, TYPE_INDEX_MAGIC, sizeof(header->magic)) != 0) {
+    throw std::runtime_error("Invalid type index '" + path + "'");
+  }
+  size_t expectedSize = sizeof(TypeIndexHeader) + header->nbPredicates * sizeof(uint64_t) +
+                        (header->nbSubjects + header->nbObjects + 4) * sizeof(uint64_t) +
+                        2 * header->nbPairs * sizeof(uint32_t);
+  if (file->getSize() != expectedSize) {
+    throw std::runtime_error("Invalid type index '" + path + "'");
+  }
+  nbTriples = header->nbTriples;
+  nbSubjects = header->nbSubjects;
+  nbObjects = header->nbObjects;
+  hdtFileSize = header->hdtFileSize;
+  hdtFileTime = header->hdtFileTime;
+  const uint64_t *predicateIDs = (const uint64_t *) (header + 1);
+  predicates.assign(predicateIDs, predicateIDs + header->nbPredicates);
+  typesIndptr = predicateIDs + header->nbPredicates;
+  entitiesIndptr = typesIndptr + nbSubjects + 2;
+  types = (const uint32_t *) (entitiesIndptr + nbObjects + 2);
+  entities = types + header->nbPairs;
+}
+
+bool TypeIndex::isValidFor(HDT *hdt, std::string hdtFile, std::vector<size_t> &_predicates) {
+  // the counts of the dictionary do not detect a HDT file rewritten with other triples
+  uint64_t fileSize = 0, fileTime = 0;
+  statFile(hdtFile, fileSize, fileTime);
+  return hdtFileSize == fileSize && hdtFileTime == fileTime &&
+         nbTriples == hdt->getTriples()->getNumberOfElements() &&
+         nbSubjects == hdt->getDictionary()->getMaxSubjectID() &&
+         nbObjects == hdt->getDictionary()->getMaxObjectID() && predicates == _predicates;
+}
+
+std::string TypeIndex::getPath() { return file->getPath(); }
+
+std::vector<size_t> TypeIndex::getPredicates() { return predicates; }
+
+void TypeIndex::getTypes(size_t subject, const uint32_t *&begin, const uint32_t *&end) {
+  if (subject == 0 || subject > nbSubjects) {
+    begin = end = types;
+    return;
+  }
+  begin = types + typesIndptr[subject];
+  end = types + typesIndptr[subject + 1];
+}
+
+void TypeIndex::getEntities(size_t object, const uint32_t *&begin, const uint32_t *&end) {
+  if (object == 0 || object > nbObjects) {
+    begin = end = entities;
+    return;
+  }
+  begin = entities + entitiesIndptr[object];
+  end = entities + entitiesIndptr[object + 1];
+}
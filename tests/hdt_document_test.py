@@ -1,7 +1,8 @@
 # hdt_document_test.py
 # Author: Thomas MINIER - MIT License 2017-2018
 import pytest
-from hdt import HDTDocument
+import numpy as np
+from hdt import HDTDocument, TripleComponentRole
 
 path = "tests/test.hdt"
 document = HDTDocument(path)
@@ -49,3 +50,415 @@ def test_ids_to_string():
         assert subj == s
         assert pred == p
         assert obj == o
+
+
+def test_search_filters():
+    (triples, cardinality) = document.search_triples("", "", "")
+    triples = list(triples)
+    literals = [t for t in triples if t[2].startswith('"')]
+    (filtered, filteredCard) = document.search_triples("", "", "", filters=[("object", "literal")])
+    assert filteredCard == cardinality
+    assert list(filtered) == literals
+    (filtered, _) = document.search_triples("", "", "", filters=[("object", "iri")])
+    assert len(list(filtered)) == len(triples) - len(literals)
+    (filtered, _) = document.search_triples("", "", "", limit=2, offset=1, filters=[("object", "literal")])
+    assert list(filtered) == literals[1:3]
+    (filtered, _) = document.search_triples("", "", "", filters=[("subject", "prefix", "http://example.org/s1")])
+    assert list(filtered) == [t for t in triples if t[0].startswith("http://example.org/s1")]
+    (filtered, _) = document.search_triples("", "", "", filters=[("object", "lang", "EN")])
+    assert list(filtered) == [t for t in literals if t[2].endswith('"@en')]
+    (ids, _) = document.search_triples_ids("", "", "", filters=[("object", "literal")])
+    assert len(list(ids)) == len(literals)
+
+
+def test_search_invalid_filters():
+    with pytest.raises(RuntimeError):
+        document.search_triples("", "", "", filters=[("graph", "literal")])
+    with pytest.raises(RuntimeError):
+        document.search_triples("", "", "", filters=[("object", "regex", ".*")])
+
+
+def test_search_many():
+    patterns = [
+        ("http://example.org/s2", "", ""),
+        ("http://example.org/s1", "http://example.org/p1", ""),
+        ("http://example.org/unknown", "", ""),
+        ("http://example.org/s2", "", "")
+    ]
+    (offsets, triples) = document.search_many(patterns)
+    assert len(offsets) == len(patterns) + 1
+    assert triples.shape == (offsets[-1], 3)
+    # unknown RDF terms match nothing
+    assert offsets[2] == offsets[3]
+    for i, (s, p, o) in enumerate(patterns):
+        if i == 2:
+            continue
+        (expected, _) = document.search_triples_ids(s, p, o)
+        results = [tuple(t) for t in triples[offsets[i]:offsets[i + 1]]]
+        assert results == list(expected)
+    (ids, _) = document.search_triples_ids("http://example.org/s1", "", "")
+    ids = list(ids)
+    (offsets, triples) = document.search_many(np.array([[ids[0][0], 0, 0], [0, ids[0][1], ids[0][2]]]), limit=2)
+    assert offsets[1] == min(2, len(ids))
+    assert [tuple(t) for t in triples[0:offsets[1]]] == ids[0:2]
+    # IDs outside of the dictionary match nothing
+    (offsets, triples) = document.search_many(np.array([[100000, 0, 0], [0, 100000, 0], [0, 0, 100000]]))
+    assert list(offsets) == [0, 0, 0, 0]
+    assert triples.shape == (0, 3)
+
+
+def test_contains():
+    (triples, _) = document.search_triples("", "", "")
+    (s, p, o) = next(triples)
+    assert document.contains(s, p, o)
+    assert document.contains(s, "", "")
+    assert not document.contains("http://example.org/unknown", "", "")
+    (ids, _) = document.search_triples_ids(s, p, o)
+    (sid, pid, oid) = next(ids)
+    assert document.contains(sid, pid, oid)
+    assert document.contains(0, 0, 0)
+    # IDs out of the dictionary match nothing
+    assert not document.contains(100000, 0, 0)
+    assert not document.contains(0, 0, 100000)
+
+
+def test_contains_many():
+    (ids, _) = document.search_triples_ids("", "", "")
+    ids = list(ids)
+    patterns = [list(t) for t in ids[0:20]]
+    # mix existing triples with missing ones and partially bound patterns
+    patterns += [[s, p, o + 1000] for (s, p, o) in ids[0:5]]
+    patterns += [[ids[0][0], 0, 0], [0, ids[0][1], 0], [10000, 0, 0]]
+    results = document.contains_many(np.array(patterns, dtype=np.uint32), threads=2)
+    assert results.shape == (len(patterns),)
+    # IDs out of the dictionary match nothing
+    assert not results[-1]
+    for (s, p, o), found in zip(patterns[:-1], results[:-1]):
+        (expected, _) = document.search_triples_ids(s, p, o)
+        assert bool(found) == (len(list(expected)) > 0)
+
+
+def test_degrees():
+    nodes = np.arange(1, document.nb_subjects + document.nb_objects - document.nb_shared + 1, dtype=np.uint32)
+    out_degrees = document.out_degree(nodes)
+    in_degrees = document.in_degree(nodes)
+    assert out_degrees.shape == nodes.shape
+    assert out_degrees.sum() == nbTotalTriples
+    assert in_degrees.sum() == nbTotalTriples
+    # degrees computed from the cache are the same
+    assert (document.out_degree(nodes, cache=True) == out_degrees).all()
+    assert (document.in_degree(nodes, cache=True, threads=2) == in_degrees).all()
+    (triples, _) = document.search_triples_ids("", "", "")
+    (s, p, o) = next(triples)
+    (expected, _) = document.search_triples_ids(s, p, "")
+    assert document.out_degree(np.array([s], dtype=np.uint32), predicate=p)[0] == len(list(expected))
+
+
+def test_neighbors():
+    nodes = np.arange(1, document.nb_subjects + 1, dtype=np.uint32)
+    (indptr, neighbors, predicates) = document.neighbors(nodes, threads=2)
+    assert len(indptr) == len(nodes) + 1
+    assert (np.diff(indptr) == document.out_degree(nodes)).all()
+    assert len(neighbors) == len(predicates) == indptr[-1]
+    p = predicates[0]
+    (indptr_p, _, predicates_p) = document.neighbors(nodes, predicates=[p])
+    assert (predicates_p == p).all()
+    assert (np.diff(indptr_p) == document.out_degree(nodes, predicate=p)).all()
+    (indptr_both, _, _) = document.neighbors(nodes, direction="both")
+    assert (np.diff(indptr_both) == document.out_degree(nodes) + document.in_degree(nodes)).all()
+    with pytest.raises(RuntimeError):
+        document.neighbors(nodes, direction="up")
+
+
+def test_sample_triples():
+    (triples, _) = document.search_triples_ids("", "", "")
+    all_triples = set(triples)
+    sample = document.sample_triples(500, seed=42)
+    assert sample.shape == (500, 3)
+    assert all(tuple(t) in all_triples for t in sample)
+    assert (document.sample_triples(500, seed=42, threads=1) == sample).all()
+    (s, p, o) = sample[0]
+    sample = document.sample_triples(50, pattern=(s, p, 0), seed=1)
+    assert (sample[:, 0] == s).all() and (sample[:, 1] == p).all()
+    sample = document.sample_triples(50, pattern=(0, p, 0), seed=1)
+    assert (sample[:, 1] == p).all()
+    assert (document.sample_triples(20, pattern=None, seed=42) == document.sample_triples(20, seed=42)).all()
+    assert document.sample_triples(0, pattern=(s, p, 100000)).shape == (0, 3)
+    with pytest.raises(RuntimeError):
+        document.sample_triples(10, pattern=(s, p, 100000))
+
+
+def test_random_walks(tmp_path):
+    nodes = np.arange(1, document.nb_subjects + 1, dtype=np.uint32)
+    walks = document.random_walks(nodes, walks_per_node=3, length=5, direction="both", seed=7, threads=2)
+    assert walks.shape == (3 * len(nodes), 5)
+    assert (walks[0:len(nodes), 0] == nodes).all()
+    for walk in walks:
+        for (source, target) in zip(walk[:-1], walk[1:]):
+            if target == 0:
+                break
+            (indptr, neighbors, _) = document.neighbors(np.array([source], dtype=np.uint32), direction="both")
+            assert target in neighbors
+    # walks only depend on the seed
+    assert (document.random_walks(nodes, walks_per_node=3, length=5, direction="both", seed=7, threads=1) == walks).all()
+    biased = document.random_walks(nodes, length=5, direction="both", p=0.5, q=2.0, seed=7)
+    assert biased.shape == (len(nodes), 5)
+    path = str(tmp_path / "walks.txt")
+    assert document.write_random_walks(path, nodes, walks_per_node=3, length=5, direction="both", seed=7) == len(walks)
+    with open(path) as f:
+        lines = [[int(x) for x in line.split()] for line in f]
+    assert lines == [[x for x in walk if x != 0] for walk in walks]
+    with pytest.raises(RuntimeError):
+        document.random_walks(nodes, p=0)
+
+
+def test_negative_samples():
+    positives = document.sample_triples(20, seed=3)
+    negatives = document.negative_samples(positives, k=4, mode="tail", seed=5, threads=2)
+    assert negatives.shape == (80, 3)
+    # every row is a negative sample
+    assert (negatives != 0).all()
+    for i, (s, p, o) in enumerate(negatives):
+        assert s == positives[i // 4][0] and p == positives[i // 4][1]
+        assert not document.contains(int(s), int(p), int(o))
+    assert (document.negative_samples(positives, k=4, mode="tail", seed=5, threads=1) == negatives).all()
+    negatives = document.negative_samples(positives, k=2, mode="head", filtered=False, seed=5)
+    assert (negatives[:, 1:] == np.repeat(positives, 2, axis=0)[:, 1:]).all()
+    assert (negatives[:, 0] >= 1).all() and (negatives[:, 0] <= document.nb_subjects).all()
+    with pytest.raises(RuntimeError):
+        document.negative_samples(positives, mode="middle")
+    # positives must be triples of IDs of the dictionary
+    with pytest.raises(RuntimeError):
+        document.negative_samples(np.array([[0, 1, 1]], dtype=np.uint32))
+    with pytest.raises(RuntimeError):
+        document.negative_samples(np.array([[1, 1, 100000]], dtype=np.uint32))
+
+
+def test_compute_hops_arrays():
+    document.configure_hops(1, [], "", True, False)
+    (entities, predicates, matrix) = document.compute_all_hops([1, 2])
+    (entities_arr, predicates_arr, adjacency) = document.compute_all_hops_arrays([1, 2])
+    assert list(entities_arr) == list(entities)
+    assert list(predicates_arr) == list(predicates)
+    assert len(adjacency) == len(matrix)
+    for ((rows, cols), edges) in zip(adjacency, matrix):
+        assert rows.dtype == np.uint32 and cols.dtype == np.uint32
+        assert list(zip(rows, cols)) == [tuple(e) for e in edges]
+
+
+def test_propagate():
+    document.configure_hops(1, [], "", True, False)
+    (entities, _, _) = document.compute_all_hops([1])
+    (nodes, ranks) = document.propagate([1], iterations=20, threads=2)
+    assert list(nodes) == list(entities)
+    assert ranks.dtype == np.float64
+    assert abs(ranks.sum() - 1.0) < 1e-6
+    assert ranks[list(nodes).index(1)] == ranks.max()
+    (_, activations) = document.propagate([1], mode="spread", iterations=2)
+    assert len(activations) == len(nodes)
+    assert activations.max() <= 1.0
+    with pytest.raises(RuntimeError):
+        document.propagate([1], mode="heat")
+
+
+def test_hop_cache():
+    document.configure_hops(1, [], "", True, False)
+    expected = document.compute_all_hops([1, 2])
+    document.configure_hop_cache(1 << 20)
+    assert document.compute_all_hops([1, 2]) == expected
+    assert document.compute_all_hops([1, 2]) == expected
+    stats = document.hop_cache_stats()
+    assert stats["hits"] > 0 and stats["misses"] > 0
+    assert 0 < stats["bytes"] <= stats["capacity"] == 1 << 20
+    # neighbourhoods computed with other filters are not reused
+    (_, predicates, _) = expected
+    document.configure_hops(1, [predicates[0]], "", True, False)
+    (_, filtered, _) = document.compute_all_hops([1, 2])
+    assert list(filtered) == [predicates[0]]
+    document.configure_hops(1, [], "", True, False)
+    assert document.compute_all_hops([1, 2]) == expected
+    document.clear_hop_cache()
+    assert document.hop_cache_stats()["entries"] == 0
+    document.configure_hop_cache(0)
+    document.configure_hops(1, [], "", True, False)
+
+
+def test_compute_hops_paged():
+    document.configure_hops(1, [], "", True, False)
+    (entities, predicates, matrix) = document.compute_all_hops([1, 2])
+    results = document.compute_hops_paged([1, 2])
+    assert list(results.entities) == list(entities)
+    assert len(results) == sum(len(edges) for edges in matrix)
+    expected = [(p, s, o) for (p, edges) in zip(predicates, matrix) for (s, o) in edges]
+    edges = []
+    for offset in range(0, len(results), 7):
+        (page_predicates, rows, cols) = results.page(7, offset)
+        assert len(page_predicates) <= 7
+        edges += list(zip(page_predicates, rows, cols))
+    assert edges == expected
+    (page_predicates, _, _) = results.page(10, len(results))
+    assert len(page_predicates) == 0
+
+
+def test_hops_degree_caps():
+    document.configure_hops(1, [], "", True, False)
+    (_, _, matrix) = document.compute_all_hops([1])
+    nb_edges = sum(len(edges) for edges in matrix)
+    assert document.nb_hubs == 0
+    document.configure_hops(1, [], "", True, False, max_out_degree=1, max_in_degree=1)
+    (_, _, matrix) = document.compute_all_hops([1])
+    assert sum(len(edges) for edges in matrix) == 0
+    assert document.nb_hubs > 0
+    document.configure_hops(1, [], "", True, False, max_out_degree=1, max_in_degree=1, truncate_hubs=True)
+    (_, _, matrix) = document.compute_all_hops([1])
+    assert 0 < sum(len(edges) for edges in matrix) <= min(2, nb_edges)
+    document.configure_hops(1, [], "", True, False)
+
+
+def test_sample_neighborhood():
+    seeds = np.arange(1, 4, dtype=np.uint32)
+    (nodes, blocks) = document.sample_neighborhood(seeds, [3, 2], direction="both", seed=11, threads=2)
+    assert len(nodes) == 3 and len(blocks) == 2
+    assert (nodes[0] == seeds).all()
+    for layer, fanout in enumerate([3, 2]):
+        (src, dst, predicates) = blocks[layer]
+        assert len(src) == len(dst) == len(predicates)
+        assert (nodes[layer + 1][:len(nodes[layer])] == nodes[layer]).all()
+        assert (np.bincount(dst, minlength=len(nodes[layer])) <= fanout).all()
+        for (s, d) in zip(src, dst):
+            (_, neighbors, _) = document.neighbors(np.array([nodes[layer][d]], dtype=np.uint32), direction="both")
+            assert nodes[layer + 1][s] in neighbors
+    (same_nodes, _) = document.sample_neighborhood(seeds, [3, 2], direction="both", seed=11, threads=1)
+    assert all((a == b).all() for (a, b) in zip(nodes, same_nodes))
+
+
+def test_filter_types():
+    rdf_type = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type"
+    document.configure_hops(1, [], "", True, False)
+    (triples, _) = document.search_triples_ids("", rdf_type, "")
+    expected = {}
+    for (s, p, o) in triples:
+        expected.setdefault(o, set()).add(s)
+    terms = list(range(1, document.nb_subjects + 1))
+    classes = list(expected.keys())
+    # filter_types expects global ids for classes
+    to_global = lambda o: o if o <= document.nb_shared else o + document.nb_subjects - document.nb_shared
+    results = document.filter_types(terms, [to_global(c) for c in classes])
+    assert len(results) == len(classes)
+    for (c, entities) in zip(classes, results):
+        assert entities == [t for t in terms if t in expected[c]]
+
+
+def test_type_index(tmp_path):
+    rdf_type = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type"
+    document.configure_hops(1, [], "", True, False)
+    ids = np.arange(1, document.nb_subjects + 1, dtype=np.uint32)
+    (expected_indptr, expected_types) = document.types_of(ids)
+    path = str(tmp_path / "test.types")
+    assert document.load_type_index([rdf_type], path, threads=2)
+    assert not document.load_type_index([rdf_type], path)
+    (indptr, types) = document.types_of(ids)
+    assert (indptr == expected_indptr).all()
+    assert (types == expected_types).all()
+    classes = list(np.unique(types))
+    results = document.filter_types(list(ids), classes)
+    for (c, entities) in zip(classes, results):
+        assert entities == [i for (k, i) in enumerate(ids) if c in types[indptr[k]:indptr[k + 1]]]
+    # another type predicate gives another index
+    assert document.load_type_index(["http://example.org/unknown"], path)
+    (indptr, types) = document.types_of(ids)
+    assert len(types) == 0
+    assert document.load_type_index([rdf_type], path)
+
+
+def test_type_index_hdt_file_changed(tmp_path):
+    import os
+    import shutil
+    rdf_type = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type"
+    hdt_path = str(tmp_path / "test.hdt")
+    shutil.copyfile(path, hdt_path)
+    doc = HDTDocument(hdt_path)
+    assert doc.load_type_index([rdf_type])
+    assert not doc.load_type_index([rdf_type])
+    # the same triples, but another modification time of the HDT file
+    info = os.stat(hdt_path)
+    os.utime(hdt_path, (info.st_atime, info.st_mtime - 10))
+    assert doc.load_type_index([rdf_type])
+
+
+def test_global_ids():
+    document.configure_hops(1, [], "", True, False)
+    nb_shared = document.nb_shared
+    nb_subjects = document.nb_subjects
+    objects = np.arange(1, document.nb_objects + 1, dtype=np.uint32)
+    global_objects = document.to_global_ids(objects, TripleComponentRole.OBJECT)
+    expected = np.where(objects > nb_shared, objects + (nb_subjects - nb_shared), objects)
+    assert (global_objects == expected).all()
+    subjects = np.arange(1, nb_subjects + 1, dtype=np.uint32)
+    assert (document.to_global_ids(subjects, TripleComponentRole.SUBJECT) == subjects).all()
+    (ids, roles) = document.from_global_ids(global_objects)
+    assert (ids == objects).all()
+    assert (roles[objects > nb_shared] == int(TripleComponentRole.OBJECT)).all()
+    assert (roles[objects <= nb_shared] == int(TripleComponentRole.SUBJECT)).all()
+    step = max(1, len(objects) // 10)
+    for (o, g) in zip(objects[::step], global_objects[::step]):
+        term = document.id_to_string(int(o), TripleComponentRole.OBJECT)
+        assert document.global_id_to_string(int(g), TripleComponentRole.OBJECT) == term
+
+
+def test_string_to_global_id_objects():
+    document.configure_hops(1, [], "", True, False)
+    # objects whose ids are also ids of subjects, but which are not shared
+    objects = np.arange(document.nb_shared + 1, document.nb_subjects + 1, dtype=np.uint32)
+    global_objects = document.to_global_ids(objects, TripleComponentRole.OBJECT)
+    for (o, g) in zip(objects, global_objects):
+        term = document.id_to_string(int(o), TripleComponentRole.OBJECT)
+        assert document.string_to_global_id(term, TripleComponentRole.OBJECT) == g
+
+
+def test_compute_hops_roles():
+    document.configure_hops(1, [], "", True, False)
+
+    def global_edges(terms):
+        (entities, predicates, matrix) = document.compute_all_hops(terms)
+        return {(entities[s], p, entities[o]) for (p, edges) in zip(predicates, matrix) for (s, o) in edges}
+
+    obj = document.string_to_global_id("http://example.org/o001", TripleComponentRole.OBJECT)
+    subject = document.string_to_global_id("http://example.org/s1", TripleComponentRole.SUBJECT)
+    # a subject after an object keeps its own role
+    assert global_edges([obj, subject]) == global_edges([obj]) | global_edges([subject])
+
+
+def test_pickle(tmp_path):
+    import pickle
+    rdf_type = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type"
+    doc = HDTDocument(path)
+    doc.configure_hops(2, [], "", True, False)
+    doc.configure_joins(hash_join_min_cardinality=7, parallel_min_cardinality=9)
+    doc.load_type_index([rdf_type], str(tmp_path / "test.types"))
+    copy = pickle.loads(pickle.dumps(doc))
+    assert copy.__getstate__() == doc.__getstate__()
+    assert copy.file_path == doc.file_path
+    assert copy.total_triples == doc.total_triples
+    terms = [document.string_to_global_id("http://example.org/s1", TripleComponentRole.SUBJECT)]
+    assert copy.compute_hops(terms, 100, 0) == doc.compute_hops(terms, 100, 0)
+    ids = np.arange(1, doc.nb_subjects + 1, dtype=np.uint32)
+    (indptr, types) = copy.types_of(ids)
+    (expected_indptr, expected_types) = doc.types_of(ids)
+    assert (indptr == expected_indptr).all() and (types == expected_types).all()
+    # the ID ranges of a prefix filter are restored without scanning the dictionary
+    doc.configure_hops(1, [], "http://example.org/s", True, True)
+    copy = pickle.loads(pickle.dumps(doc))
+    assert copy.__getstate__() == doc.__getstate__()
+    assert copy.compute_hops(terms, 100, 0) == doc.compute_hops(terms, 100, 0)
+    # cached degrees can be stored in a file shared between processes
+    cache_path = str(tmp_path / "test.degrees")
+    assert (copy.out_degree(ids, cache=True, cache_path=cache_path) == doc.out_degree(ids)).all()
+    assert (doc.in_degree(ids, cache=True, cache_path=cache_path) == copy.in_degree(ids)).all()
+    # the file stays mapped until the last document using it is removed
+    doc.remove()
+    assert copy.total_triples == nbTotalTriples
+    (triples, cardinality) = copy.search_triples("", "", "")
+    assert len(list(triples)) == cardinality
+    copy.remove()
+    assert document.total_triples == nbTotalTriples
@@ -97,3 +97,58 @@ def test_ids_iterator_big_offset():
     for s, p, o in triples:
         nbItems += 1
     assert nbItems == 0
+
+
+def test_string_iterator_prefetch():
+    (expected, _) = document.search_triples("", "", "")
+    (triples, cardinality) = document.search_triples("", "", "", prefetch=8)
+    assert cardinality == nbTotalTriples
+    assert triples.peek() == next(triples)
+    assert [next(triples)] + list(triples) == list(expected)[1:]
+    assert triples.nb_reads == nbTotalTriples
+    # the producer decodes terms while the consumer uses the dictionary
+    (ids, _) = document.search_triples_ids("", "", "")
+    (triples, _) = document.search_triples("", "", "", prefetch=2)
+    for (s, p, o), t in zip(ids, triples):
+        assert document.tripleid_to_string(s, p, o) == t
+    # dropping a prefetching iterator before its end must not block
+    (triples, _) = document.search_triples("", "", "", prefetch=4)
+    next(triples)
+    del triples
+
+
+def test_string_iterator_next_batch():
+    (expected, _) = document.search_triples("", "", "", limit=20, offset=3)
+    expected = list(expected)
+    (triples, _) = document.search_triples("", "", "", limit=20, offset=3)
+    assert triples.peek() == expected[0]
+    batch = triples.next_batch(15)
+    assert batch == expected[0:15]
+    assert triples.next_batch(15) == expected[15:]
+    assert triples.next_batch(15) == []
+
+
+def test_ids_iterator_next_batch():
+    (expected, _) = document.search_triples_ids("", "", "", limit=20, offset=3)
+    expected = list(expected)
+    (triples, _) = document.search_triples_ids("", "", "", limit=20, offset=3)
+    assert triples.peek() == expected[0]
+    batch = triples.next_batch(15)
+    assert batch.shape == (15, 3)
+    assert [tuple(t) for t in batch] == expected[0:15]
+    assert [tuple(t) for t in triples.next_batch(15)] == expected[15:]
+    assert triples.next_batch(15).shape == (0, 3)
+
+
+def test_string_iterator_raw():
+    (expected, _) = document.search_triples("", "", "", limit=10)
+    expected = [tuple(term.encode("utf-8") for term in t) for t in expected]
+    (triples, _) = document.search_triples("", "", "", limit=10, raw=True)
+    assert triples.peek() == expected[0]
+    assert list(triples) == expected
+    (triples, _) = document.search_triples("", "", "", limit=10, raw=True)
+    (buffer, offsets) = triples.next_batch(10)
+    assert isinstance(buffer, bytes)
+    assert len(offsets) == 3 * len(expected) + 1
+    terms = [buffer[offsets[i]:offsets[i + 1]] for i in range(len(offsets) - 1)]
+    assert [tuple(terms[i:i + 3]) for i in range(0, len(terms), 3)] == expected
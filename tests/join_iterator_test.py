@@ -17,3 +17,119 @@ def test_basic_join():
         assert len(b) == 1
         assert ('?s', 'http://example.org/s1') in b or ('?s', 'http://example.org/s2') in b
     assert cpt == 2
+
+
+def test_hash_join_spill():
+    # the predicate variable prevents a star join, so the planner uses a hash join
+    patterns = [
+        ("?s", "http://example.org/p1", "?o"),
+        ("?s", "?p", "?o2")
+    ]
+    expected = set(frozenset(b) for b in document.search_join(patterns))
+    document.configure_joins(hash_join_min_cardinality=1)
+    try:
+        in_memory = [frozenset(b) for b in document.search_join(patterns)]
+        # a budget of one byte partitions both inputs on disk
+        spilled = [frozenset(b) for b in document.search_join(patterns, memory_budget=1)]
+    finally:
+        document.configure_joins()
+    assert len(expected) > 0
+    assert len(in_memory) == len(spilled) == len(expected)
+    assert set(in_memory) == set(spilled) == expected
+
+
+def test_join_threads():
+    # object-object join, evaluated with index lookups, so workers split the
+    # driving pattern and align their slices on the join variable
+    patterns = [
+        ("?s", "http://example.org/p1", "?o"),
+        ("?s2", "http://example.org/p2", "?o")
+    ]
+    expected = set(frozenset(b) for b in document.search_join(patterns))
+    # the fixture is smaller than the default threshold of parallel joins
+    document.configure_joins(parallel_min_cardinality=1)
+    try:
+        results = [frozenset(b) for b in document.search_join(patterns, threads=4)]
+    finally:
+        document.configure_joins()
+    assert len(expected) == 20
+    assert len(results) == len(expected)
+    assert set(results) == expected
+
+
+def test_join_threads_hash_join():
+    # workers probe the same hash table, built once
+    patterns = [
+        ("?s", "http://example.org/p1", "?o"),
+        ("?s", "?p", "?o2")
+    ]
+    expected = set(frozenset(b) for b in document.search_join(patterns))
+    document.configure_joins(hash_join_min_cardinality=1, parallel_min_cardinality=1)
+    try:
+        shared = [frozenset(b) for b in document.search_join(patterns, threads=4)]
+        # the budget covers all hash tables, so a tiny budget falls back to index lookups
+        lookups = [frozenset(b) for b in document.search_join(patterns, memory_budget=1, threads=4)]
+    finally:
+        document.configure_joins()
+    assert len(expected) > 0
+    assert len(shared) == len(lookups) == len(expected)
+    assert set(shared) == set(lookups) == expected
+
+
+def test_star_join():
+    p1 = "http://example.org/p1"
+    o010 = "http://example.org/o010"
+    patterns = [
+        ("?s", p1, "?o"),
+        ("?s", p1, o010)
+    ]
+    # nested loop over the first pattern, checking the second one for each subject
+    expected = set()
+    (triples, cardinality) = document.search_triples("", p1, "")
+    for s, p, o in triples:
+        (matches, cardinality) = document.search_triples(s, p1, o010)
+        for match in matches:
+            expected.add(frozenset([("?s", s), ("?o", o)]))
+    assert len(expected) == 110
+    document.configure_joins(parallel_min_cardinality=1)
+    try:
+        for threads in [1, 4]:
+            results = [frozenset(b) for b in document.search_join(patterns, threads=threads)]
+            assert len(results) == len(expected)
+            assert set(results) == expected
+    finally:
+        document.configure_joins()
+
+
+def test_join_limit_offset():
+    patterns = [
+        ("?s", "http://example.org/p1", "?o"),
+        ("?s2", "http://example.org/p2", "?o")
+    ]
+    expected = [frozenset(b) for b in document.search_join(patterns, offset=0, limit=0)]
+    assert len(expected) == 20
+    join_iter = document.search_join(patterns, limit=1)
+    assert len(join_iter) <= 1
+    results = [b for b in join_iter]
+    assert len(results) == 1
+    results = [frozenset(b) for b in document.search_join(patterns, offset=1)]
+    assert len(results) == 19
+    assert set(results) < set(expected)
+    results = [frozenset(b) for b in document.search_join(patterns, limit=5, offset=18)]
+    assert len(results) == 2
+    assert set(results) < set(expected)
+
+
+def test_join_filters():
+    patterns = [
+        ("?s", "http://example.org/p1", "?o"),
+        ("?s2", "http://example.org/p2", "?o")
+    ]
+    expected = [b for b in document.search_join(patterns) if ('?s', 'http://example.org/s1') in b]
+    assert len(expected) == 10
+    results = [b for b in document.search_join(patterns, filters=[("?s", "prefix", "http://example.org/s1")])]
+    assert len(results) == len(expected)
+    for b in results:
+        assert b in expected
+    results = [b for b in document.search_join(patterns, filters=[("?o", "literal")])]
+    assert len(results) == 0